@@ -179,6 +179,7 @@ namespace Json {
       Location lastValueEnd_;
       Value *lastValue_;
       std::string commentsBefore_;
+      std::string decoded_;
       Features features_;
       bool collectComments_;
    };
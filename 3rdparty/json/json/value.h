@@ -11,6 +11,8 @@
 #endif // if !defined(JSON_IS_AMALGAMATION)
 # include <string>
 # include <vector>
+# include <cstddef>
+# include <new>
 
 # ifndef JSON_USE_CPPTL_SMALLMAP
 #  include <map>
@@ -88,6 +90,116 @@ namespace Json {
       const char *str_;
    };
 
+   /** \brief Bump allocator for the strings and members of short lived values.
+    *
+    * While an arena exists, the strings and the object and array members of all
+    * values created on the same thread are taken from it instead of the heap.
+    * The memory is not released per value, but at once when the arena is destroyed.
+    * Arenas can be nested, the innermost one is used.
+    *
+    * Values which got memory while the arena existed must be destroyed before it.
+    *
+    * Example of usage:
+    * \code
+    * {
+    *    Json::ValueArena arena;
+    *    Json::Value root;
+    *    reader.parse( document, root );
+    *    std::string name = root["name"].asString();
+    * }
+    * \endcode
+    */
+   class JSON_API ValueArena
+   {
+   public:
+      ValueArena( size_t chunkSize = 4096 );
+      ~ValueArena();
+
+      /// Allocates from the innermost arena of the current thread, or from the heap without one.
+      static void *allocate( size_t size );
+      /// Releases memory of allocate(), which is only freed if no arena of the current thread owns it.
+      static void release( void *memory );
+
+   private:
+      ValueArena( const ValueArena & );
+      ValueArena &operator =( const ValueArena & );
+
+      void *allocateFromChunk( size_t size );
+      bool owns( const void *memory ) const;
+
+      typedef std::pair<char *, size_t> Chunk;
+      std::vector<Chunk> chunks_;
+      size_t nextChunkSize_;
+      char *current_;
+      char *end_;
+      ValueArena *previous_;
+   };
+
+   /** \brief STL allocator of the object and array members, taking them from the current ValueArena.
+    */
+   template <typename T>
+   class ValueArenaAllocator
+   {
+   public:
+      typedef T value_type;
+      typedef T *pointer;
+      typedef const T *const_pointer;
+      typedef T &reference;
+      typedef const T &const_reference;
+      typedef size_t size_type;
+      typedef ptrdiff_t difference_type;
+
+      template <typename U>
+      struct rebind
+      {
+         typedef ValueArenaAllocator<U> other;
+      };
+
+      ValueArenaAllocator()
+      {
+      }
+
+      template <typename U>
+      ValueArenaAllocator( const ValueArenaAllocator<U> & )
+      {
+      }
+
+      T *allocate( size_t count, const void * = 0 )
+      {
+         return static_cast<T *>( ValueArena::allocate( count * sizeof( T ) ) );
+      }
+
+      void deallocate( T *memory, size_t )
+      {
+         ValueArena::release( memory );
+      }
+
+      void construct( T *memory, const T &value )
+      {
+         new ( memory ) T( value );
+      }
+
+      void destroy( T *memory )
+      {
+         memory->~T();
+      }
+
+      size_t max_size() const
+      {
+         return size_t(-1) / sizeof( T );
+      }
+
+      bool operator ==( const ValueArenaAllocator & ) const
+      {
+         return true;
+      }
+
+      bool operator !=( const ValueArenaAllocator & ) const
+      {
+         return false;
+      }
+   };
+
    /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
     *
     * This class is a discriminated union wrapper that can represents a:
@@ -188,7 +300,7 @@ namespace Json {
 
    public:
 #  ifndef JSON_USE_CPPTL_SMALLMAP
-      typedef std::map<CZString, Value> ObjectValues;
+      typedef std::map<CZString, Value, std::less<CZString>, ValueArenaAllocator<std::pair<const CZString, Value> > > ObjectValues;
 #  else
       typedef CppTL::SmallMap<CZString, Value> ObjectValues;
 #  endif // ifndef JSON_USE_CPPTL_SMALLMAP
@@ -633,10 +633,11 @@ Reader::decodeDouble( Token &token )
 bool 
 Reader::decodeString( Token &token )
 {
-   std::string decoded;
-   if ( !decodeString( token, decoded ) )
+   // The buffer is kept between strings, so only the value allocates
+   decoded_.clear();
+   if ( !decodeString( token, decoded_ ) )
       return false;
-   currentValue() = decoded;
+   currentValue() = decoded_;
    return true;
 }
 
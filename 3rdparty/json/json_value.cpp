@@ -14,7 +14,9 @@
 #include <utility>
 #include <stdexcept>
 #include <cstring>
+#include <cstdlib>
 #include <cassert>
+#include <new>
 #ifdef JSON_USE_CPPTL
 # include <cpptl/conststring.h>
 #endif
@@ -56,8 +58,7 @@ duplicateStringValue( const char *value,
 {
    if ( length == unknown )
       length = (unsigned int)strlen(value);
-   char *newString = static_cast<char *>( malloc( length + 1 ) );
-   JSON_ASSERT_MESSAGE( newString != 0, "Failed to allocate string value buffer" );
+   char *newString = static_cast<char *>( ValueArena::allocate( length + 1 ) );
    memcpy( newString, value, length );
    newString[length] = 0;
    return newString;
@@ -70,9 +71,43 @@ static inline void
 releaseStringValue( char *value )
 {
    if ( value )
-      free( value );
+      ValueArena::release( value );
 }
 
+
+#ifndef JSON_VALUE_USE_INTERNAL_MAP
+/** Creates the members of an object or array value, in the current arena if there is one.
+ * @param other Members to copy or 0 for empty members.
+ */
+static inline Value::ObjectValues *
+duplicateObjectValues( const Value::ObjectValues *other = 0 )
+{
+   void *memory = ValueArena::allocate( sizeof( Value::ObjectValues ) );
+   try
+   {
+      if ( other )
+         return new ( memory ) Value::ObjectValues( *other );
+      return new ( memory ) Value::ObjectValues();
+   }
+   catch ( ... )
+   {
+      ValueArena::release( memory );
+      throw;
+   }
+}
+
+
+/** Destroys the members created by duplicateObjectValues().
+ */
+static inline void 
+releaseObjectValues( Value::ObjectValues *values )
+{
+   typedef Value::ObjectValues ObjectValues;
+   values->~ObjectValues();
+   ValueArena::release( values );
+}
+#endif // ifndef JSON_VALUE_USE_INTERNAL_MAP
+
 } // namespace Json
 
 
@@ -94,6 +129,109 @@ releaseStringValue( char *value )
 
 namespace Json {
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class ValueArena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+/// Innermost arena of the current thread
+static thread_local ValueArena *currentArena = 0;
+
+/// Alignment of all allocations, enough for pointers and doubles
+static const size_t arenaAlignment = 2 * sizeof( void * ) < sizeof( double ) ? sizeof( double ) : 2 * sizeof( void * );
+
+/// Size up to which the chunks of an arena grow
+static const size_t maxArenaChunkSize = 1024 * 1024;
+
+
+ValueArena::ValueArena( size_t chunkSize )
+   : nextChunkSize_( chunkSize )
+   , current_( 0 )
+   , end_( 0 )
+   , previous_( currentArena )
+{
+   currentArena = this;
+}
+
+
+ValueArena::~ValueArena()
+{
+   currentArena = previous_;
+   for ( std::vector<Chunk>::iterator chunk = chunks_.begin(); chunk != chunks_.end(); ++chunk )
+      free( chunk->first );
+}
+
+
+void *
+ValueArena::allocate( size_t size )
+{
+   if ( currentArena )
+      return currentArena->allocateFromChunk( size );
+
+   void *memory = malloc( size ? size : 1 );
+   if ( !memory )
+      throw std::bad_alloc();
+   return memory;
+}
+
+
+void 
+ValueArena::release( void *memory )
+{
+   // Memory of an arena is only freed with the arena itself
+   for ( ValueArena *arena = currentArena; arena; arena = arena->previous_ )
+   {
+      if ( arena->owns( memory ) )
+         return;
+   }
+   free( memory );
+}
+
+
+void *
+ValueArena::allocateFromChunk( size_t size )
+{
+   size = ( size + arenaAlignment - 1 ) & ~( arenaAlignment - 1 );
+   if ( size > size_t( end_ - current_ ) )
+   {
+      // Oversized allocations get their own chunk, the current one stays in use
+      size_t chunkSize = size > nextChunkSize_ ? size : nextChunkSize_;
+      char *chunk = static_cast<char *>( malloc( chunkSize ) );
+      if ( !chunk )
+         throw std::bad_alloc();
+      chunks_.push_back( Chunk( chunk, chunkSize ) );
+
+      if ( chunkSize > nextChunkSize_ )
+         return chunk;
+
+      current_ = chunk;
+      end_ = chunk + chunkSize;
+      if ( nextChunkSize_ < maxArenaChunkSize )
+         nextChunkSize_ *= 2;
+   }
+
+   void *memory = current_;
+   current_ += size;
+   return memory;
+}
+
+
+bool 
+ValueArena::owns( const void *memory ) const
+{
+   const char *address = static_cast<const char *>( memory );
+   for ( std::vector<Chunk>::const_reverse_iterator chunk = chunks_.rbegin(); chunk != chunks_.rend(); ++chunk )
+   {
+      if ( address >= chunk->first  &&  address < chunk->first + chunk->second )
+         return true;
+   }
+   return false;
+}
+
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -258,7 +396,7 @@ Value::Value( ValueType type )
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
    case arrayValue:
    case objectValue:
-      value_.map_ = new ObjectValues();
+      value_.map_ = duplicateObjectValues();
       break;
 #else
    case arrayValue:
@@ -435,7 +573,7 @@ Value::Value( const Value &other )
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
    case arrayValue:
    case objectValue:
-      value_.map_ = new ObjectValues( *other.value_.map_ );
+      value_.map_ = duplicateObjectValues( other.value_.map_ );
       break;
 #else
    case arrayValue:
@@ -478,7 +616,7 @@ Value::~Value()
 #ifndef JSON_VALUE_USE_INTERNAL_MAP
    case arrayValue:
    case objectValue:
-      delete value_.map_;
+      releaseObjectValues( value_.map_ );
       break;
 #else
    case arrayValue:
@@ -28,6 +28,7 @@
 #define _CALLBACK_H_
 
 #include "CallbackFunction.h"
+#include "Message.h"
 #include <memory>
 #include <string>
 
@@ -39,6 +40,9 @@ private:
 public:
     std::shared_ptr<CallbackFunction_t> callbackFunction;
 
+    // Only set for callbacks of sent messages
+    MessageTimes_t times;
+
     explicit Callback(std::shared_ptr<CallbackFunction_t> callbackFunction, int type, std::string error);
     void Fire();
 };
@@ -28,22 +28,57 @@
 
 #define DEFAULT_WAIT_TIME_BETWEEN_MESSAGES 2000
 #define DEFAULT_WAIT_TIME_AFTER_LOGOUT 5000
+#define DEFAULT_WAIT_TIME_BETWEEN_COMMUNITY_REQUESTS 1000
+#define DEFAULT_BURST 1
 #define DEFAULT_REQUEST_TIMEOUT 30
+#define DEFAULT_MAX_QUEUED_MESSAGES 100
+#define DEFAULT_FRIEND_CHECK_INTERVAL 60000
+#define DEFAULT_STEAM_COMMUNITY_URL "https://steamcommunity.com"
+#define DEFAULT_WEB_API_URL "https://api.steampowered.com"
 
 // Global variable for accessing config
 Config messageBotConfig;
 
 Config::Config() :
+    steamCommunityUrl(DEFAULT_STEAM_COMMUNITY_URL), webApiUrl(DEFAULT_WEB_API_URL),
     waitBetweenMessages(DEFAULT_WAIT_TIME_BETWEEN_MESSAGES), waitAfterLogout(DEFAULT_WAIT_TIME_AFTER_LOGOUT),
-    requestTimeout(DEFAULT_REQUEST_TIMEOUT), debugEnabled(false), shuffleRecipients(false) {}
+    waitBetweenCommunityRequests(DEFAULT_WAIT_TIME_BETWEEN_COMMUNITY_REQUESTS), requestTimeout(DEFAULT_REQUEST_TIMEOUT),
+    messageBurst(DEFAULT_BURST), loginBurst(DEFAULT_BURST), communityBurst(DEFAULT_BURST), debugEnabled(false), shuffleRecipients(false), parallelSend(false),
+    maxQueuedMessages(DEFAULT_MAX_QUEUED_MESSAGES), queueDropPolicy(QueueDropPolicy_REJECT_NEW), batchWindow(0),
+    presenceCacheTime(0), friendCheckInterval(DEFAULT_FRIEND_CHECK_INTERVAL), callbackBudget(0) {}
 
 void Config::ResetConfig() {
     this->username = std::string();
     this->password = std::string();
+    this->steamCommunityUrl = DEFAULT_STEAM_COMMUNITY_URL;
+    this->webApiUrl = DEFAULT_WEB_API_URL;
     this->waitBetweenMessages = DEFAULT_WAIT_TIME_BETWEEN_MESSAGES;
     this->waitAfterLogout = DEFAULT_WAIT_TIME_AFTER_LOGOUT;
+    this->waitBetweenCommunityRequests = DEFAULT_WAIT_TIME_BETWEEN_COMMUNITY_REQUESTS;
     this->requestTimeout = DEFAULT_REQUEST_TIMEOUT;
+    this->messageBurst = DEFAULT_BURST;
+    this->loginBurst = DEFAULT_BURST;
+    this->communityBurst = DEFAULT_BURST;
     this->recipients.clear();
     this->debugEnabled = false;
     this->shuffleRecipients = false;
-}
\ No newline at end of file
+    this->parallelSend = false;
+    this->maxQueuedMessages = DEFAULT_MAX_QUEUED_MESSAGES;
+    this->queueDropPolicy = QueueDropPolicy_REJECT_NEW;
+    this->batchWindow = 0;
+    this->presenceCacheTime = 0;
+    this->friendCheckInterval = DEFAULT_FRIEND_CHECK_INTERVAL;
+    this->callbackBudget = 0;
+}
+
+bool Config::IsSameDelivery(const Config &other) const {
+    // Queue and callback options don't change how a message is sent
+    return this->username == other.username && this->password == other.password &&
+           this->steamCommunityUrl == other.steamCommunityUrl && this->webApiUrl == other.webApiUrl &&
+           this->waitBetweenMessages == other.waitBetweenMessages && this->waitAfterLogout == other.waitAfterLogout &&
+           this->waitBetweenCommunityRequests == other.waitBetweenCommunityRequests && this->requestTimeout == other.requestTimeout &&
+           this->messageBurst == other.messageBurst && this->loginBurst == other.loginBurst && this->communityBurst == other.communityBurst &&
+           this->recipients == other.recipients && this->debugEnabled == other.debugEnabled &&
+           this->shuffleRecipients == other.shuffleRecipients && this->parallelSend == other.parallelSend &&
+           this->presenceCacheTime == other.presenceCacheTime;
+}
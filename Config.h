@@ -30,6 +30,11 @@
 #include <string>
 #include <vector>
 
+enum QueueDropPolicy {
+    QueueDropPolicy_REJECT_NEW,
+    QueueDropPolicy_DROP_OLDEST,
+};
+
 /**
  * Config class for different stuff.
  * Class with public members, as simple setters are not meaningful.
@@ -39,18 +44,38 @@ public:
     std::string username;
     std::string password;
 
+    // Base URLs without trailing slash, only changed to test against a local server
+    std::string steamCommunityUrl;
+    std::string webApiUrl;
+
     int waitBetweenMessages;
     int waitAfterLogout;
+    int waitBetweenCommunityRequests;
     int requestTimeout;
 
+    int messageBurst;
+    int loginBurst;
+    int communityBurst;
+
     std::vector<uint64_t> recipients;
     bool debugEnabled;
     bool shuffleRecipients;
+    bool parallelSend;
+
+    int maxQueuedMessages;
+    int queueDropPolicy;
+    int batchWindow;
+    int presenceCacheTime;
+    int friendCheckInterval;
+    int callbackBudget;
 
 public:
     Config();
 
     void ResetConfig();
+
+    // Whether messages with the other config can be sent together with the same login, settings and recipients
+    bool IsSameDelivery(const Config &other) const;
 };
 
 extern Config messageBotConfig;
@@ -0,0 +1,116 @@
+/**
+ * -----------------------------------------------------
+ * File         FormBody.cpp
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "FormBody.h"
+#include "UrlEncoder.h"
+
+#include <string.h>
+
+
+FormBody &FormBody::Clear() {
+    this->body.clear();
+    return *this;
+}
+
+FormBody &FormBody::Add(const char *name, const char *value, size_t length) {
+    this->AddName(name);
+    this->AppendEncoded(value, length);
+
+    return *this;
+}
+
+FormBody &FormBody::Add(const char *name, const char *value) {
+    return this->Add(name, value, strlen(value));
+}
+
+FormBody &FormBody::Add(const char *name, const std::string &value) {
+    return this->Add(name, value.data(), value.length());
+}
+
+FormBody &FormBody::AddInt(const char *name, int64_t value) {
+    this->AddName(name);
+
+    if (value < 0) {
+        // Negate as unsigned, so the minimum value doesn't overflow
+        this->body.push_back('-');
+        this->AppendNumber(0 - static_cast<uint64_t>(value));
+    } else {
+        this->AppendNumber(static_cast<uint64_t>(value));
+    }
+
+    return *this;
+}
+
+FormBody &FormBody::AddUInt(const char *name, uint64_t value) {
+    this->AddName(name);
+    this->AppendNumber(value);
+
+    return *this;
+}
+
+const char *FormBody::GetData() const {
+    return this->body.c_str();
+}
+
+size_t FormBody::GetLength() const {
+    return this->body.length();
+}
+
+bool FormBody::IsEmpty() const {
+    return this->body.empty();
+}
+
+void FormBody::AddName(const char *name) {
+    if (!this->body.empty()) {
+        this->body.push_back('&');
+    }
+
+    this->body.append(name);
+    this->body.push_back('=');
+}
+
+void FormBody::AppendNumber(uint64_t value) {
+    char digits[20];
+    int count = 0;
+
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (count) {
+        this->body.push_back(digits[--count]);
+    }
+}
+
+void FormBody::AppendEncoded(const char *value, size_t length) {
+    // Encode straight into the buffer and cut it to the encoded length afterwards
+    size_t start = this->body.length();
+    this->body.resize(start + UrlEncoder::GetMaxLength(length));
+
+    size_t encodedLength = UrlEncoder::Encode(value, length, &this->body[start]);
+    this->body.resize(start + encodedLength);
+}
@@ -0,0 +1,63 @@
+/**
+ * -----------------------------------------------------
+ * File         FormBody.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _FORM_BODY_H_
+#define _FORM_BODY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/**
+ * Builds an urlencoded POST body field by field.
+ * The buffer is kept when the body is cleared, so a reused body doesn't allocate anymore.
+ */
+class FormBody {
+private:
+    std::string body;
+
+public:
+    // Starts a new body
+    FormBody &Clear();
+
+    // Adds a field, the name is taken as it is and the value is urlencoded
+    FormBody &Add(const char *name, const char *value, size_t length);
+    FormBody &Add(const char *name, const char *value);
+    FormBody &Add(const char *name, const std::string &value);
+    FormBody &AddInt(const char *name, int64_t value);
+    FormBody &AddUInt(const char *name, uint64_t value);
+
+    const char *GetData() const;
+    size_t GetLength() const;
+    bool IsEmpty() const;
+
+private:
+    void AddName(const char *name);
+    void AppendNumber(uint64_t value);
+    void AppendEncoded(const char *value, size_t length);
+};
+
+#endif
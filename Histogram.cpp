@@ -0,0 +1,108 @@
+/**
+ * -----------------------------------------------------
+ * File         Histogram.cpp
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "Histogram.h"
+
+
+Histogram::Histogram() : count(0), max(0) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        this->buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::Record(uint32_t value) {
+    this->buckets[Histogram::GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    this->count.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t currentMax = this->max.load(std::memory_order_relaxed);
+    while (value > currentMax && !this->max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {}
+}
+
+unsigned int Histogram::GetCount() {
+    return this->count.load(std::memory_order_relaxed);
+}
+
+uint32_t Histogram::GetMax() {
+    return this->max.load(std::memory_order_relaxed);
+}
+
+uint32_t Histogram::GetPercentile(double percentile) {
+    unsigned int total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += this->buckets[i].load(std::memory_order_relaxed);
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    // Rank of the wanted value, starting at one
+    unsigned int rank = static_cast<unsigned int>(percentile / 100.0 * total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    } else if (rank > total) {
+        rank = total;
+    }
+
+    unsigned int seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += this->buckets[i].load(std::memory_order_relaxed);
+
+        if (seen >= rank) {
+            return Histogram::GetBucketValue(i);
+        }
+    }
+
+    return this->GetMax();
+}
+
+int Histogram::GetBucket(uint32_t value) {
+    if (value < HISTOGRAM_LINEAR_BUCKETS) {
+        return static_cast<int>(value);
+    }
+
+    // Position of the highest bit, at least 4 here
+    int highestBit = 31;
+    while (!(value & (1u << highestBit))) {
+        highestBit--;
+    }
+
+    int subBucket = (value >> (highestBit - HISTOGRAM_SUB_BUCKET_BITS)) & ((1 << HISTOGRAM_SUB_BUCKET_BITS) - 1);
+    return HISTOGRAM_LINEAR_BUCKETS + (highestBit - 4) * (1 << HISTOGRAM_SUB_BUCKET_BITS) + subBucket;
+}
+
+uint32_t Histogram::GetBucketValue(int bucket) {
+    if (bucket < HISTOGRAM_LINEAR_BUCKETS) {
+        return static_cast<uint32_t>(bucket);
+    }
+
+    bucket -= HISTOGRAM_LINEAR_BUCKETS;
+
+    int highestBit = bucket / (1 << HISTOGRAM_SUB_BUCKET_BITS) + 4;
+    uint32_t subBucket = bucket % (1 << HISTOGRAM_SUB_BUCKET_BITS);
+
+    return ((1u << HISTOGRAM_SUB_BUCKET_BITS) + subBucket) << (highestBit - HISTOGRAM_SUB_BUCKET_BITS);
+}
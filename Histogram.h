@@ -0,0 +1,64 @@
+/**
+ * -----------------------------------------------------
+ * File         Histogram.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include <atomic>
+#include <stdint.h>
+
+// Values below are counted exactly, above every power of two is split into sub buckets
+#define HISTOGRAM_LINEAR_BUCKETS 16
+#define HISTOGRAM_SUB_BUCKET_BITS 3
+#define HISTOGRAM_BUCKETS (HISTOGRAM_LINEAR_BUCKETS + (32 - 4) * (1 << HISTOGRAM_SUB_BUCKET_BITS))
+
+/**
+ * Log linear histogram of 32 bit values, e.g. durations in microseconds.
+ * Recording is lock free and can be done by any thread, percentiles are accurate to 12.5%.
+ */
+class Histogram {
+private:
+    std::atomic<unsigned int> buckets[HISTOGRAM_BUCKETS];
+    std::atomic<unsigned int> count;
+    std::atomic<uint32_t> max;
+
+public:
+    Histogram();
+
+    void Record(uint32_t value);
+
+    unsigned int GetCount();
+    uint32_t GetMax();
+
+    // Returns the lower bound of the bucket containing the given percentile (0 - 100)
+    uint32_t GetPercentile(double percentile);
+
+private:
+    static int GetBucket(uint32_t value);
+    static uint32_t GetBucketValue(int bucket);
+};
+
+#endif
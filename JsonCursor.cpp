@@ -0,0 +1,475 @@
+/**
+ * -----------------------------------------------------
+ * File         JsonCursor.cpp
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "JsonCursor.h"
+
+#include <string.h>
+
+
+JsonCursor::JsonCursor(const char *begin, const char *end) : current(begin), end(end), failed(false), isFirst(false) {}
+
+JsonCursor::JsonCursor(const std::string &json) : current(json.data()), end(json.data() + json.length()), failed(false), isFirst(false) {}
+
+bool JsonCursor::EnterObject() {
+    this->SkipWhitespace();
+
+    if (this->current == this->end || *this->current != '{') {
+        this->Skip();
+        return false;
+    }
+
+    this->current++;
+    this->isFirst = true;
+
+    return true;
+}
+
+bool JsonCursor::EnterArray() {
+    this->SkipWhitespace();
+
+    if (this->current == this->end || *this->current != '[') {
+        this->Skip();
+        return false;
+    }
+
+    this->current++;
+    this->isFirst = true;
+
+    return true;
+}
+
+bool JsonCursor::NextKey(std::string &key) {
+    this->SkipWhitespace();
+    if (this->current == this->end) {
+        return this->Fail();
+    }
+
+    // End of the object, continue with the parent
+    if (*this->current == '}') {
+        this->current++;
+        this->isFirst = false;
+        return false;
+    }
+
+    if (!this->isFirst) {
+        if (*this->current != ',') {
+            return this->Fail();
+        }
+
+        this->current++;
+        this->SkipWhitespace();
+    }
+
+    if (this->current == this->end || *this->current != '"') {
+        return this->Fail();
+    }
+
+    key.clear();
+    if (!this->ParseString(&key)) {
+        return false;
+    }
+
+    this->SkipWhitespace();
+    if (this->current == this->end || *this->current != ':') {
+        return this->Fail();
+    }
+
+    this->current++;
+    this->isFirst = false;
+
+    return true;
+}
+
+bool JsonCursor::NextElement() {
+    this->SkipWhitespace();
+    if (this->current == this->end) {
+        return this->Fail();
+    }
+
+    // End of the array, continue with the parent
+    if (*this->current == ']') {
+        this->current++;
+        this->isFirst = false;
+        return false;
+    }
+
+    if (!this->isFirst) {
+        if (*this->current != ',') {
+            return this->Fail();
+        }
+
+        this->current++;
+    }
+
+    this->isFirst = false;
+    return true;
+}
+
+bool JsonCursor::ReadString(std::string &value) {
+    this->SkipWhitespace();
+
+    if (this->current == this->end || *this->current != '"') {
+        this->Skip();
+        return false;
+    }
+
+    value.clear();
+    return this->ParseString(&value);
+}
+
+bool JsonCursor::ReadInt(int64_t &value) {
+    this->SkipWhitespace();
+
+    const char *start = this->current;
+    if (start == this->end || (*start != '-' && (*start < '0' || *start > '9'))) {
+        this->Skip();
+        return false;
+    }
+
+    if (!this->SkipNumber()) {
+        return false;
+    }
+
+    // Only the integer part is used
+    bool isNegative = *start == '-';
+    if (isNegative) {
+        start++;
+    }
+
+    // The magnitude of the smallest value is one more than the one of the largest
+    uint64_t limit = isNegative ? static_cast<uint64_t>(INT64_MAX) + 1 : static_cast<uint64_t>(INT64_MAX);
+    uint64_t magnitude = 0;
+
+    for (; start < this->current && *start >= '0' && *start <= '9'; start++) {
+        unsigned int digit = *start - '0';
+
+        // Too large for the type, the number is already skipped
+        if (magnitude > (limit - digit) / 10) {
+            return false;
+        }
+
+        magnitude = magnitude * 10 + digit;
+    }
+
+    if (isNegative) {
+        value = magnitude == limit ? INT64_MIN : -static_cast<int64_t>(magnitude);
+    } else {
+        value = static_cast<int64_t>(magnitude);
+    }
+
+    return true;
+}
+
+bool JsonCursor::ReadBool(bool &value) {
+    this->SkipWhitespace();
+
+    if (this->current != this->end && *this->current == 't') {
+        value = true;
+        return this->SkipLiteral("true");
+    } else if (this->current != this->end && *this->current == 'f') {
+        value = false;
+        return this->SkipLiteral("false");
+    }
+
+    this->Skip();
+    return false;
+}
+
+bool JsonCursor::ReadUInt64(uint64_t &value) {
+    this->SkipWhitespace();
+    if (this->current == this->end) {
+        return this->Fail();
+    }
+
+    const char *start = this->current;
+    bool isString = *start == '"';
+    const char *digit = isString ? start + 1 : start;
+
+    value = 0;
+    bool isOverflow = false;
+
+    const char *digitsStart = digit;
+    for (; digit < this->end && *digit >= '0' && *digit <= '9'; digit++) {
+        unsigned int digitValue = *digit - '0';
+
+        // Too large for the type, the value is skipped like any other value
+        if (value > (UINT64_MAX - digitValue) / 10) {
+            isOverflow = true;
+        }
+
+        value = value * 10 + digitValue;
+    }
+
+    bool hasDigits = digit != digitsStart && !isOverflow;
+
+    if (isString && hasDigits && digit < this->end && *digit == '"') {
+        this->current = digit + 1;
+        return true;
+    }
+
+    if (!isString && hasDigits && (digit == this->end || (*digit != '.' && *digit != 'e' && *digit != 'E'))) {
+        this->current = digit;
+        return true;
+    }
+
+    // Any other value
+    this->Skip();
+    return false;
+}
+
+bool JsonCursor::Skip() {
+    this->SkipWhitespace();
+    if (this->current == this->end) {
+        return this->Fail();
+    }
+
+    switch (*this->current) {
+        case '{': {
+            this->current++;
+            this->isFirst = true;
+
+            std::string key;
+            while (this->NextKey(key)) {
+                if (!this->Skip()) {
+                    return false;
+                }
+            }
+
+            return !this->failed;
+        }
+        case '[': {
+            this->current++;
+            this->isFirst = true;
+
+            while (this->NextElement()) {
+                if (!this->Skip()) {
+                    return false;
+                }
+            }
+
+            return !this->failed;
+        }
+        case '"':
+            return this->ParseString(nullptr);
+        case 't':
+            return this->SkipLiteral("true");
+        case 'f':
+            return this->SkipLiteral("false");
+        case 'n':
+            return this->SkipLiteral("null");
+        default:
+            return this->SkipNumber();
+    }
+}
+
+bool JsonCursor::HasFailed() const {
+    return this->failed;
+}
+
+void JsonCursor::SkipWhitespace() {
+    while (this->current < this->end && (*this->current == ' ' || *this->current == '\t' || *this->current == '\n' || *this->current == '\r')) {
+        this->current++;
+    }
+}
+
+bool JsonCursor::Fail() {
+    this->failed = true;
+    this->current = this->end;
+
+    return false;
+}
+
+bool JsonCursor::ParseString(std::string *value) {
+    // Skip the quote
+    this->current++;
+
+    while (true) {
+        // Copy everything up to the next quote or escape at once
+        const char *start = this->current;
+        while (this->current < this->end && *this->current != '"' && *this->current != '\\') {
+            if (static_cast<unsigned char>(*this->current) < 0x20) {
+                return this->Fail();
+            }
+
+            this->current++;
+        }
+
+        if (value) {
+            value->append(start, this->current - start);
+        }
+
+        if (this->current == this->end) {
+            return this->Fail();
+        }
+
+        if (*this->current++ == '"') {
+            return true;
+        }
+
+        // Escape sequence
+        if (this->current == this->end) {
+            return this->Fail();
+        }
+
+        char escape = *this->current++;
+        char unescaped;
+
+        switch (escape) {
+            case '"': unescaped = '"'; break;
+            case '\\': unescaped = '\\'; break;
+            case '/': unescaped = '/'; break;
+            case 'b': unescaped = '\b'; break;
+            case 'f': unescaped = '\f'; break;
+            case 'n': unescaped = '\n'; break;
+            case 'r': unescaped = '\r'; break;
+            case 't': unescaped = '\t'; break;
+            case 'u': {
+                unsigned int codePoint;
+                if (this->end - this->current < 4 || !JsonCursor::ParseHex(this->current, codePoint)) {
+                    return this->Fail();
+                }
+
+                this->current += 4;
+
+                // Combine surrogate pairs
+                unsigned int lowSurrogate;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF && this->end - this->current >= 6 && this->current[0] == '\\' && this->current[1] == 'u' &&
+                    JsonCursor::ParseHex(this->current + 2, lowSurrogate) && lowSurrogate >= 0xDC00 && lowSurrogate <= 0xDFFF) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                    this->current += 6;
+                }
+
+                if (value) {
+                    // Encode as UTF-8
+                    if (codePoint < 0x80) {
+                        value->push_back(static_cast<char>(codePoint));
+                    } else if (codePoint < 0x800) {
+                        value->push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                        value->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                    } else if (codePoint < 0x10000) {
+                        value->push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                        value->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                        value->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                    } else {
+                        value->push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                        value->push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                        value->push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                        value->push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                    }
+                }
+
+                continue;
+            }
+            default:
+                return this->Fail();
+        }
+
+        if (value) {
+            value->push_back(unescaped);
+        }
+    }
+}
+
+bool JsonCursor::SkipNumber() {
+    const char *start = this->current;
+
+    if (this->current < this->end && *this->current == '-') {
+        this->current++;
+    }
+
+    const char *digits = this->current;
+    while (this->current < this->end && *this->current >= '0' && *this->current <= '9') {
+        this->current++;
+    }
+
+    if (this->current == digits) {
+        this->current = start;
+        return this->Fail();
+    }
+
+    if (this->current < this->end && *this->current == '.') {
+        this->current++;
+
+        digits = this->current;
+        while (this->current < this->end && *this->current >= '0' && *this->current <= '9') {
+            this->current++;
+        }
+
+        if (this->current == digits) {
+            return this->Fail();
+        }
+    }
+
+    if (this->current < this->end && (*this->current == 'e' || *this->current == 'E')) {
+        this->current++;
+
+        if (this->current < this->end && (*this->current == '+' || *this->current == '-')) {
+            this->current++;
+        }
+
+        digits = this->current;
+        while (this->current < this->end && *this->current >= '0' && *this->current <= '9') {
+            this->current++;
+        }
+
+        if (this->current == digits) {
+            return this->Fail();
+        }
+    }
+
+    return true;
+}
+
+bool JsonCursor::ParseHex(const char *hex, unsigned int &value) {
+    value = 0;
+
+    for (int i = 0; i < 4; i++) {
+        value <<= 4;
+
+        if (hex[i] >= '0' && hex[i] <= '9') {
+            value |= hex[i] - '0';
+        } else if (hex[i] >= 'a' && hex[i] <= 'f') {
+            value |= hex[i] - 'a' + 10;
+        } else if (hex[i] >= 'A' && hex[i] <= 'F') {
+            value |= hex[i] - 'A' + 10;
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JsonCursor::SkipLiteral(const char *literal) {
+    size_t length = strlen(literal);
+
+    if (static_cast<size_t>(this->end - this->current) < length || memcmp(this->current, literal, length) != 0) {
+        return this->Fail();
+    }
+
+    this->current += length;
+    return true;
+}
@@ -0,0 +1,88 @@
+/**
+ * -----------------------------------------------------
+ * File         JsonCursor.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _JSON_CURSOR_H_
+#define _JSON_CURSOR_H_
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Pull parser reading single values straight from a JSON text without building a Json::Value tree.
+ * Objects and arrays are entered and walked with NextKey and NextElement, every value has to be read or skipped.
+ * After a syntax error all functions return false and HasFailed returns true.
+ * The text isn't copied and has to outlive the cursor.
+ */
+class JsonCursor {
+private:
+    const char *current;
+    const char *end;
+    bool failed;
+
+    // Whether the next key or element is the first one of the current object or array
+    bool isFirst;
+
+public:
+    JsonCursor(const char *begin, const char *end);
+    explicit JsonCursor(const std::string &json);
+
+    // Enters the object or array at the current position, false if it's another value, which is skipped then
+    bool EnterObject();
+    bool EnterArray();
+
+    // Moves to the next key of the current object, false at its end
+    bool NextKey(std::string &key);
+
+    // Moves to the next element of the current array, false at its end
+    bool NextElement();
+
+    // Reads the value at the current position, false if it has another type or doesn't fit, which is skipped then
+    bool ReadString(std::string &value);
+    bool ReadInt(int64_t &value);
+    bool ReadBool(bool &value);
+
+    // Reads a number or a string containing a number, like steam sends 64 bit IDs, false if it doesn't fit
+    bool ReadUInt64(uint64_t &value);
+
+    // Skips the value at the current position
+    bool Skip();
+
+    // Whether the text isn't valid JSON
+    bool HasFailed() const;
+
+private:
+    void SkipWhitespace();
+    bool Fail();
+
+    bool ParseString(std::string *value);
+    bool SkipNumber();
+    bool SkipLiteral(const char *literal);
+
+    // Parses four hex digits of an unicode escape
+    static bool ParseHex(const char *hex, unsigned int &value);
+};
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * -----------------------------------------------------
+ * File         MPSCQueue.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _MPSC_QUEUE_H_
+#define _MPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+/**
+ * Lock free queue with many producers and a single consumer.
+ * Push can be called from any thread, Pop, IsEmpty and Clear only from the consumer thread.
+ * A push in progress may not be visible yet, the consumer then just sees it on the next pop.
+ */
+template <typename T>
+class MPSCQueue {
+private:
+    struct Node {
+        std::atomic<Node *> next;
+        T value;
+
+        Node() : next(nullptr) {}
+    };
+
+    // Last pushed node, shared by all producers
+    std::atomic<Node *> head;
+
+    // Already consumed node, the next one holds the next value
+    Node *tail;
+
+public:
+    MPSCQueue() {
+        Node *stub = new Node();
+
+        this->head.store(stub);
+        this->tail = stub;
+    }
+
+    ~MPSCQueue() {
+        this->Clear();
+        delete this->tail;
+    }
+
+    MPSCQueue(const MPSCQueue &) = delete;
+    MPSCQueue &operator=(const MPSCQueue &) = delete;
+
+    void Push(T value) {
+        Node *node = new Node();
+        node->value = std::move(value);
+
+        // Link the node after the previous head, the consumer can't see it until then
+        Node *previous = this->head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    bool Pop(T &value) {
+        Node *next = this->tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+
+        // The next node becomes the new consumed node
+        value = std::move(next->value);
+        next->value = T();
+
+        delete this->tail;
+        this->tail = next;
+
+        return true;
+    }
+
+    bool IsEmpty() {
+        return this->tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    void Clear() {
+        T value;
+        while (this->Pop(value)) {}
+    }
+};
+
+#endif
@@ -29,6 +29,7 @@
 
 #include "Config.h"
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -38,4 +39,13 @@ typedef struct {
     std::string text;
 } Message;
 
+// Points in time a message passed on its way to the recipients
+typedef struct {
+    std::chrono::steady_clock::time_point queueTime;
+    std::chrono::steady_clock::time_point takeTime;
+    std::chrono::steady_clock::time_point loginTime;
+    std::chrono::steady_clock::time_point firstDeliveryTime;
+    std::chrono::steady_clock::time_point lastDeliveryTime;
+} MessageTimes_t;
+
 #endif
@@ -25,10 +25,19 @@
  */
 
 #include "MessageBot.h"
+#include "MessageThread.h"
 #include "natives.h"
 #include "Config.h"
+#include "WebAPI.h"
 
 #include <curl/curl.h>
+#include <string.h>
+
+// Number of frames after which the message thread state is checked although nothing was queued
+#define FRAMES_BETWEEN_STATE_CHECKS 64
+
+// Maximum number of times the friend check interval is doubled after failed logins, 64 times the interval
+#define MAX_FRIEND_CHECK_BACKOFF 6
 
 #if defined _WIN32 || defined _WIN64
 #define sleep_ms(x) Sleep(x);
@@ -39,16 +48,58 @@
 
 MessageBot::MessageBot() {
     this->mutex = nullptr;
+    this->messageSignal = nullptr;
     this->isRunning = false;
-    this->runningThread = nullptr;
     this->messageThread = nullptr;
+    this->isMessageThreadActive = false;
+    this->isMessageThreadWaiting = false;
+    this->isFriendCheckDue = false;
+    this->friendCheckLoginErrors = 0;
+    this->isWakeUpPending = false;
+    this->framesSinceStateCheck = 0;
+    this->webApi = nullptr;
+    this->shareClient = nullptr;
 }
 
 bool MessageBot::SDK_OnLoad(char *error, size_t maxlength, bool late) {
     this->isRunning = true;
 
-    // Creates needed mutex
+    // Creates needed mutex and the signal to wake up the message thread
     this->mutex = threader->MakeMutex();
+    this->messageSignal = threader->MakeEventSignal();
+
+    // Init CURL
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    // Create the web API after CURL is initialized, connections are kept alive between messages
+    this->shareClient = WebAPI::CreateShareClient();
+    this->webApi = new WebAPI(this->shareClient);
+
+    // Start the message thread, which waits for messages until unload
+    this->isMessageThreadActive = true;
+    this->isFriendCheckDue = false;
+    this->friendCheckLoginErrors = 0;
+    this->nextFriendCheck = std::chrono::steady_clock::now();
+
+    MessageThread *thread = new MessageThread();
+    this->messageThread = threader->MakeThread(thread, Thread_Default);
+    if (!this->messageThread) {
+        delete thread;
+
+        delete this->webApi;
+        this->webApi = nullptr;
+        WebAPI::DestroyShareClient(this->shareClient);
+        this->shareClient = nullptr;
+        curl_global_cleanup();
+
+        this->messageSignal->DestroyThis();
+        this->mutex->DestroyThis();
+        this->isRunning = false;
+        this->isMessageThreadActive = false;
+
+        snprintf(error, maxlength, "Couldn't create the message thread");
+        return false;
+    }
 
     // Add natives and register library
     sharesys->AddNatives(myself, messagebot_natives);
@@ -60,8 +111,8 @@ bool MessageBot::SDK_OnLoad(char *error, size_t maxlength, bool late) {
     // Add this plugin listener
     plsys->AddPluginsListener(this);
 
-    // Init CURL
-    curl_global_init(CURL_GLOBAL_ALL);
+    // Add the root console command for statistics
+    rootconsole->AddRootConsoleCommand3("messagebot", "MessageBot", this);
 
     // Loaded
     return true;
@@ -78,32 +129,52 @@ void MessageBot::SDK_OnUnload() {
 
     this->mutex->Unlock();
 
-    // Wait until running thread is finished
-    if (runningThread) {
-        rootconsole->ConsolePrint("[MessageBot] Please wait until running thread is finished...");
-        this->runningThread->WaitForThread();
-        this->runningThread = nullptr;
-        rootconsole->ConsolePrint("[MessageBot] Thread finished executing");
-    }
+    // Wake up the message thread until it noticed that it has to stop and wait until it's finished
+    rootconsole->ConsolePrint("[MessageBot] Please wait until message thread is finished...");
+
+    while (true) {
+        this->mutex->Lock();
+        bool isFinished = !this->isMessageThreadActive;
+        bool isWaiting = this->isMessageThreadWaiting;
+        this->mutex->Unlock();
 
-    // Remove all waiting threads
-    for (auto it = this->waitingThreads.begin(); it != waitingThreads.end(); ++it) {
-        (*it)->DestroyThis();
+        if (isFinished) {
+            break;
+        }
+
+        // A sending thread will notice the stop after the message is sent
+        if (isWaiting) {
+            this->messageSignal->Signal();
+        }
+
+        sleep_ms(1);
     }
 
+    this->messageThread->WaitForThread();
+    this->messageThread->DestroyThis();
+    this->messageThread = nullptr;
+    rootconsole->ConsolePrint("[MessageBot] Thread finished executing");
+
     // Remove plugin listener
     plsys->RemovePluginsListener(this);
 
+    // Remove root console command
+    rootconsole->RemoveRootConsoleCommand("messagebot", this);
+
     // Clear STL stuff
-    this->callbackQueue.clear();
+    this->callbackQueue.Clear();
     this->callbackFunctions.clear();
-    this->waitingThreads.clear();
+    this->messageQueue.clear();
 
-    // Remove created mutex
+    // Remove created mutex and signal
+    this->messageSignal->DestroyThis();
     this->mutex->DestroyThis();
 
-    // Reset the message thread value
-    this->messageThread = nullptr;
+    // Remove the web API, no thread is using it anymore
+    delete this->webApi;
+    this->webApi = nullptr;
+    WebAPI::DestroyShareClient(this->shareClient);
+    this->shareClient = nullptr;
 
     // Reset config values at end
     messageBotConfig.ResetConfig();
@@ -111,7 +182,6 @@ void MessageBot::SDK_OnUnload() {
     // Finally clean up CURL
     curl_global_cleanup();
 }
-
 void MessageBot::OnPluginUnloaded(IPlugin *plugin) {
     // Search if the plugin has any pending callback functions and invalidate them
     for (auto it = this->callbackFunctions.begin(); it != callbackFunctions.end();) {
@@ -126,17 +196,9 @@ void MessageBot::OnPluginUnloaded(IPlugin *plugin) {
 }
 
 void MessageBot::AppendCallback(std::shared_ptr<Callback> callback) {
-    // Lock mutex to gain thread safety
-    while (!this->mutex->TryLock()) {
-        sleep_ms(1);
-    }
-
-    if (this->isRunning) {
-        // Add the callback to the queue and unlock mutex again
-        this->callbackQueue.push_back(callback);
-    }
-
-    this->mutex->Unlock();
+    // The queue is lock free, callbacks left on unload are cleared after the message thread finished
+    this->callbackQueue.Push(callback);
+    this->stats.callbacksQueued.fetch_add(1, std::memory_order_relaxed);
 }
 
 std::shared_ptr<CallbackFunction_t> MessageBot::CreateCallbackFunction(IPluginFunction *function) {
@@ -173,76 +235,335 @@ std::shared_ptr<CallbackFunction_t> MessageBot::CreateCallbackFunction(IPluginFu
     return callbackFunction;
 }
 
+WebAPI *MessageBot::GetWebAPI() {
+    return this->webApi;
+}
 
-bool MessageBot::RegisterAndStartThread(IThread *thread) {
-    // Create the thread suspended, add it to the list of waiting threads
-    IThreadHandle *handle = threader->MakeThread(thread, Thread_CreateSuspended);
-    if (!handle) {
-        return false;
+
+bool MessageBot::QueueMessage(Message message, std::shared_ptr<CallbackFunction_t> callbackFunction) {
+    QueuedMessage_t queuedMessage;
+    queuedMessage.message = message;
+    queuedMessage.callbackFunction = callbackFunction;
+    queuedMessage.queueTime = std::chrono::steady_clock::now();
+
+    std::shared_ptr<CallbackFunction_t> droppedCallbackFunction = nullptr;
+    size_t maxQueuedMessages = messageBotConfig.maxQueuedMessages > 0 ? messageBotConfig.maxQueuedMessages : 0;
+
+    this->mutex->Lock();
+
+    bool isQueued = true;
+    if (maxQueuedMessages && this->messageQueue.size() >= maxQueuedMessages) {
+        if (messageBotConfig.queueDropPolicy == QueueDropPolicy_DROP_OLDEST) {
+            // Make space for the new message by dropping the oldest one
+            droppedCallbackFunction = this->messageQueue.front().callbackFunction;
+            this->messageQueue.pop_front();
+            this->messageQueue.push_back(queuedMessage);
+        } else {
+            // Reject the new message
+            droppedCallbackFunction = callbackFunction;
+            isQueued = false;
+        }
+    } else {
+        this->messageQueue.push_back(queuedMessage);
+    }
+
+    bool wakeUpThread = isQueued && this->isMessageThreadWaiting;
+
+    this->mutex->Unlock();
+
+    // Let the frame hook check if the signal was missed
+    if (isQueued) {
+        this->isWakeUpPending = true;
+    }
+
+    if (wakeUpThread) {
+        this->messageSignal->Signal();
+    }
+
+    // Notify the plugin of the dropped message on the next frame
+    if (droppedCallbackFunction) {
+        this->AppendCallback(std::make_shared<Callback>(droppedCallbackFunction, WebAPIResult_QUEUE_FULL, "Message queue is full"));
+    }
+
+    return isQueued;
+}
+
+bool MessageBot::WaitForMessage(QueuedMessage_t &queuedMessage, Config &friendCheckConfig, bool &isFriendCheck) {
+    isFriendCheck = false;
+
+    while (true) {
+        this->mutex->Lock();
+
+        if (!this->isRunning) {
+            // Extension is unloading, stop the thread
+            this->isMessageThreadWaiting = false;
+            this->isMessageThreadActive = false;
+            this->mutex->Unlock();
+
+            return false;
+        }
+
+        if (!this->messageQueue.empty()) {
+            queuedMessage = this->messageQueue.front();
+            this->messageQueue.pop_front();
+
+            this->TakeMessage(queuedMessage);
+
+            this->isMessageThreadWaiting = false;
+            this->mutex->Unlock();
+
+            return true;
+        }
+
+        if (this->isFriendCheckDue) {
+            // Nothing to send, so there is time to accept friends
+            friendCheckConfig = this->friendCheckConfig;
+            isFriendCheck = true;
+
+            this->isFriendCheckDue = false;
+            this->isMessageThreadWaiting = false;
+            this->mutex->Unlock();
+
+            return true;
+        }
+
+        this->isMessageThreadWaiting = true;
+        this->mutex->Unlock();
+
+        // Wait until a new message arrives, the game frame hook wakes us up again if a signal was missed
+        this->messageSignal->Wait();
     }
+}
 
+void MessageBot::FinishFriendCheck(WebAPIResult_t &result) {
     this->mutex->Lock();
-    this->waitingThreads.push_back(handle);
+
+    if (result.type == WebAPIResult_LOGIN_ERROR) {
+        // Wrong login data won't get right by itself, so don't try it every interval
+        if (this->friendCheckLoginErrors < MAX_FRIEND_CHECK_BACKOFF) {
+            this->friendCheckLoginErrors++;
+        }
+
+        auto backoff = std::chrono::milliseconds(static_cast<int64_t>(this->friendCheckConfig.friendCheckInterval) << this->friendCheckLoginErrors);
+        this->nextFriendCheck = std::chrono::steady_clock::now() + backoff;
+    } else {
+        this->friendCheckLoginErrors = 0;
+    }
+
     this->mutex->Unlock();
+}
 
-    return true;
+void MessageBot::TakeBatchMessages(Config &batchConfig, std::vector<QueuedMessage_t> &batch) {
+    this->mutex->Lock();
+
+    // Take all messages which can be sent within the same session, with the same settings to the same recipients
+    for (auto it = this->messageQueue.begin(); it != this->messageQueue.end();) {
+        Config &config = it->message.config;
+
+        if (config.batchWindow > 0 && config.IsSameDelivery(batchConfig)) {
+            this->TakeMessage(*it);
+
+            batch.push_back(*it);
+            it = this->messageQueue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    this->mutex->Unlock();
 }
 
-void MessageBot::UnregisterAndDeleteThreadHandle(IThreadHandle *threadHandle) {
-    while (!this->mutex->TryLock()) {
-        sleep_ms(1);
+void MessageBot::TakeMessage(QueuedMessage_t &queuedMessage) {
+    queuedMessage.takeTime = std::chrono::steady_clock::now();
+
+    auto waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(queuedMessage.takeTime - queuedMessage.queueTime).count();
+    this->stats.latencies[LatencyPhase_TAKEN].Record(static_cast<uint32_t>(waitTime));
+}
+
+void MessageBot::RecordLatencies(MessageTimes_t &times, std::chrono::steady_clock::time_point fireTime) {
+    std::chrono::steady_clock::time_point phaseTimes[] = { times.loginTime, times.firstDeliveryTime, times.lastDeliveryTime, fireTime };
+    LatencyPhase phases[] = { LatencyPhase_LOGGED_IN, LatencyPhase_FIRST_DELIVERED, LatencyPhase_LAST_DELIVERED, LatencyPhase_CALLBACK_FIRED };
+
+    // The taken phase is already recorded by the message thread
+    for (int i = 0; i < 4; i++) {
+        if (phaseTimes[i] == std::chrono::steady_clock::time_point()) {
+            continue;
+        }
+
+        auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(phaseTimes[i] - times.queueTime).count();
+        this->stats.latencies[phases[i]].Record(static_cast<uint32_t>(latency));
     }
+}
 
-    // Destroy the thread handle to free resources
-    this->runningThread = nullptr;
-    threadHandle->DestroyThis();
+size_t MessageBot::GetQueueSize() {
+    this->mutex->Lock();
+    size_t size = this->messageQueue.size();
+    this->mutex->Unlock();
+
+    return size;
+}
 
+bool MessageBot::IsRunning() {
+    this->mutex->Lock();
+    bool isRunning = this->isRunning;
     this->mutex->Unlock();
+
+    return isRunning;
 }
 
 void MessageBot::OnGameFrameHit(bool simulating) {
+    this->stats.frameHookCalls.fetch_add(1, std::memory_order_relaxed);
+
+    // Are there outstandig callbacks? This is a single atomic load if not
+    bool hasCallbacks = !this->callbackQueue.IsEmpty();
+
+    // Only look at the message thread if a message was queued or from time to time for friend checks
+    bool checkMessageThread = this->isWakeUpPending || ++this->framesSinceStateCheck >= FRAMES_BETWEEN_STATE_CHECKS;
+
+    if (!hasCallbacks && !checkMessageThread) {
+        return;
+    }
+
+    auto frameStart = std::chrono::steady_clock::now();
+
+    if (hasCallbacks) {
+        this->FireCallbacks(frameStart);
+    }
+
+    if (checkMessageThread) {
+        this->CheckMessageThread();
+    }
+
+    this->stats.frameHookBusyCalls.fetch_add(1, std::memory_order_relaxed);
+    this->stats.frameHookTime.Record(static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frameStart).count()));
+}
+
+void MessageBot::FireCallbacks(std::chrono::steady_clock::time_point frameStart) {
+    // Without a budget only one callback is fired per frame
+    int callbackBudget = messageBotConfig.callbackBudget;
+
+    std::shared_ptr<Callback> callback = nullptr;
+    while (this->callbackQueue.Pop(callback)) {
+        this->stats.callbacksTaken.fetch_add(1, std::memory_order_relaxed);
+
+        if (callback->callbackFunction->isValid && callback->callbackFunction->function->IsRunnable()) {
+            // Fire the callback if the callback function is valid
+            callback->Fire();
+            this->stats.callbacksFired.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Dropped messages were never sent, so they have no times
+        if (callback->times.queueTime != std::chrono::steady_clock::time_point()) {
+            this->RecordLatencies(callback->times, std::chrono::steady_clock::now());
+        }
+
+        if (callbackBudget <= 0 || std::chrono::steady_clock::now() - frameStart >= std::chrono::microseconds(callbackBudget)) {
+            break;
+        }
+    }
+}
+
+void MessageBot::CheckMessageThread() {
+    this->framesSinceStateCheck = 0;
+
     // Lock the mutex to gain thread safety
     if (!this->mutex->TryLock()) {
         // Couldn't lock -> do not wait
         return;
     }
 
-    // Are there outstandig callbacks?
-    std::shared_ptr<Callback> callback = nullptr;
-    if (this->isRunning && !this->callbackQueue.empty()) {
-        callback = this->callbackQueue.front();
+    // Is the message thread waiting although there is work?
+    bool wakeUpThread = this->isRunning && this->isMessageThreadWaiting && (!this->messageQueue.empty() || this->isFriendCheckDue);
 
-        // Remove the callback from the queue
-        // No deleting needed, as callbacks are shared pointers
-        callbackQueue.pop_front();
-    }
+    // Let the idle message thread check for new friend requests from time to time
+    if (this->isRunning && this->isMessageThreadWaiting && messageBotConfig.friendCheckInterval > 0 && !this->isFriendCheckDue) {
+        auto now = std::chrono::steady_clock::now();
+
+        // New login data may work again, so don't wait for the backoff of the old one
+        if (this->friendCheckLoginErrors > 0 && (messageBotConfig.username != this->friendCheckConfig.username ||
+                                                 messageBotConfig.password != this->friendCheckConfig.password)) {
+            this->friendCheckLoginErrors = 0;
+            this->nextFriendCheck = now;
+        }
 
-    // Are there waiting threads?
-    IThreadHandle *waitingThread = nullptr;
-    if (this->isRunning && !this->runningThread && !this->waitingThreads.empty()) {
-        waitingThread = this->waitingThreads.front();
+        if (now >= this->nextFriendCheck) {
+            this->friendCheckConfig = messageBotConfig;
+            this->isFriendCheckDue = true;
+            this->nextFriendCheck = now + std::chrono::milliseconds(messageBotConfig.friendCheckInterval);
 
-        // Remove the waiting thread from the queue
-        waitingThreads.pop_front();
+            wakeUpThread = true;
+        }
     }
 
+    // Keep checking until the thread woke up, a busy message thread takes the remaining work without waiting
+    this->isWakeUpPending = wakeUpThread;
+
     // Unlock mutex
     this->mutex->Unlock();
 
-    // Proccess callback and thread outside mutex lock to avoid infinite loop
-    if (callback) {
-        if (callback->callbackFunction->isValid && callback->callbackFunction->function->IsRunnable()) {
-            // Fire the callback if the callback function is valid
-            callback->Fire();
+    // Signal outside mutex lock to avoid infinite loop
+    if (wakeUpThread) {
+        this->messageSignal->Signal();
+    }
+}
+
+void MessageBot::OnRootConsoleCommand(const char *cmdname, const ICommandArgs *args) {
+    if (args->ArgC() >= 3 && strcmp(args->Arg(2), "stats") == 0) {
+        this->PrintStats();
+        return;
+    }
+
+    if (args->ArgC() >= 3 && strcmp(args->Arg(2), "latency") == 0) {
+        this->PrintLatencies();
+        return;
+    }
+
+    if (args->ArgC() >= 3 && strcmp(args->Arg(2), "trace") == 0) {
+        // One request per line, the console can't print the whole buffer at once
+        std::vector<std::string> records = this->webApi->GetRequestTraceRecords();
+        for (auto record = records.begin(); record != records.end(); record++) {
+            rootconsole->ConsolePrint("%s", record->c_str());
         }
+        return;
     }
 
-    if (waitingThread) {
-        this->runningThread = waitingThread;
-        waitingThread->Unpause();
+    rootconsole->ConsolePrint("SourceMod MessageBot Menu:");
+    rootconsole->DrawGenericOption("stats", "Show statistics about the costs of the extension");
+    rootconsole->DrawGenericOption("latency", "Show the time from sending a message until it reached each phase");
+    rootconsole->DrawGenericOption("trace", "Show the timings of the last requests to steam as JSON, newest first");
+}
+
+void MessageBot::PrintStats() {
+    Histogram &frameHookTime = this->stats.frameHookTime;
+    Histogram &queueWaitTime = this->stats.latencies[LatencyPhase_TAKEN];
+
+    rootconsole->ConsolePrint("[MessageBot] Frame hook calls: %u (with work: %u)",
+                              this->stats.frameHookCalls.load(), this->stats.frameHookBusyCalls.load());
+    rootconsole->ConsolePrint("[MessageBot] Frame hook time with work: p50 %u us, p99 %u us, max %u us",
+                              frameHookTime.GetPercentile(50), frameHookTime.GetPercentile(99), frameHookTime.GetMax());
+    rootconsole->ConsolePrint("[MessageBot] Callbacks fired: %u, waiting: %u",
+                              this->stats.callbacksFired.load(), this->stats.GetCallbackQueueSize());
+    rootconsole->ConsolePrint("[MessageBot] Messages waiting: %u", static_cast<unsigned int>(this->GetQueueSize()));
+    rootconsole->ConsolePrint("[MessageBot] Message wait time in queue: p50 %u ms, p99 %u ms, max %u ms",
+                              queueWaitTime.GetPercentile(50), queueWaitTime.GetPercentile(99), queueWaitTime.GetMax());
+}
+
+void MessageBot::PrintLatencies() {
+    const char *phaseNames[LatencyPhase_MAX] = { "Taken by thread", "Logged in", "First delivered", "Last delivered", "Callback fired" };
+
+    for (int phase = 0; phase < LatencyPhase_MAX; phase++) {
+        Histogram &latency = this->stats.latencies[phase];
+
+        rootconsole->ConsolePrint("[MessageBot] %-16s p50 %u ms, p95 %u ms, p99 %u ms (%u messages)", phaseNames[phase],
+                                  latency.GetPercentile(50), latency.GetPercentile(95), latency.GetPercentile(99), latency.GetCount());
     }
 }
 
+Stats &MessageBot::GetStats() {
+    return this->stats;
+}
+
 void MessageBot_OnGameFrameHit(bool simulating) {
     messageBot.OnGameFrameHit(simulating);
 }
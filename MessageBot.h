@@ -30,39 +30,91 @@
 #include "sdk/smsdk_ext.h"
 #include "Callback.h"
 #include "CallbackFunction.h"
+#include "Config.h"
+#include "Message.h"
+#include "MPSCQueue.h"
+#include "Stats.h"
 #include "WebAPIResult.h"
 
+#include <curl/curl.h>
+#include <chrono>
 #include <string>
 #include <deque>
 #include <vector>
 
-class MessageBot : public SDKExtension, public IPluginsListener {
+class WebAPI;
+
+typedef struct {
+    Message message;
+    std::shared_ptr<CallbackFunction_t> callbackFunction;
+    std::chrono::steady_clock::time_point queueTime;
+    std::chrono::steady_clock::time_point takeTime;
+} QueuedMessage_t;
+
+class MessageBot : public SDKExtension, public IPluginsListener, public IRootConsoleCommand {
 private:
     IMutex *mutex;
+    IEventSignal *messageSignal;
 
-    std::deque<std::shared_ptr<Callback>> callbackQueue;
+    // Filled by any thread, emptied by the game frame hook without locking
+    MPSCQueue<std::shared_ptr<Callback>> callbackQueue;
     std::vector<std::shared_ptr<CallbackFunction_t>> callbackFunctions;
-    std::deque<IThreadHandle *> waitingThreads;
+    std::deque<QueuedMessage_t> messageQueue;
 
-    IThreadHandle *runningThread;
     IThreadHandle *messageThread;
+    bool isMessageThreadActive;
+    bool isMessageThreadWaiting;
+
+    // Friend requests are accepted by the message thread while no message is queued
+    bool isFriendCheckDue;
+    Config friendCheckConfig;
+    std::chrono::steady_clock::time_point nextFriendCheck;
+
+    // Failed logins of the friend check in a row, every one doubles the time until the next check
+    int friendCheckLoginErrors;
+
+    // Only used by the game thread, so the frame hook doesn't need to lock while idle
+    bool isWakeUpPending;
+    int framesSinceStateCheck;
+
+    // Shared by all messages, so the steam session survives between messages
+    WebAPI *webApi;
+    CURLSH *shareClient;
 
     bool isRunning;
 
+    Stats stats;
+
 public:
     MessageBot();
 
     virtual bool SDK_OnLoad(char *error, size_t maxlength, bool late);
     virtual void SDK_OnUnload();
     virtual void OnPluginUnloaded(IPlugin *plugin);
+    virtual void OnRootConsoleCommand(const char *cmdname, const ICommandArgs *args);
 
     void AppendCallback(std::shared_ptr<Callback> callback);
     std::shared_ptr<CallbackFunction_t> CreateCallbackFunction(IPluginFunction *function);
 
-    bool RegisterAndStartThread(IThread *thread);
-    void UnregisterAndDeleteThreadHandle(IThreadHandle *threadHandle);
+    WebAPI *GetWebAPI();
+
+    bool QueueMessage(Message message, std::shared_ptr<CallbackFunction_t> callbackFunction);
+    bool WaitForMessage(QueuedMessage_t &queuedMessage, Config &friendCheckConfig, bool &isFriendCheck);
+    void FinishFriendCheck(WebAPIResult_t &result);
+    void TakeBatchMessages(Config &batchConfig, std::vector<QueuedMessage_t> &batch);
+    size_t GetQueueSize();
+    bool IsRunning();
+    Stats &GetStats();
 
     void OnGameFrameHit(bool simulating);
+
+private:
+    void FireCallbacks(std::chrono::steady_clock::time_point frameStart);
+    void CheckMessageThread();
+    void TakeMessage(QueuedMessage_t &queuedMessage);
+    void RecordLatencies(MessageTimes_t &times, std::chrono::steady_clock::time_point fireTime);
+    void PrintStats();
+    void PrintLatencies();
 };
 
 void MessageBot_OnGameFrameHit(bool simulating);
@@ -29,19 +29,104 @@
 #include "Callback.h"
 #include "WebAPI.h"
 
-MessageThread::MessageThread(Message message, std::shared_ptr<CallbackFunction_t> callbackFunction) :
-    message(message), callbackFunction(callbackFunction) {}
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Maximum length of a single steam chat message
+#define MAX_MESSAGE_LENGTH 2048
+
+#if defined _WIN32 || defined _WIN64
+#define sleep_ms(x) Sleep(x);
+#else
+#define sleep_ms(x) usleep(x * 1000);
+#endif
+
 
 void MessageThread::RunThread(IThreadHandle *pHandle) {
-    // Send message via Webapi
-    WebAPI webApi;
-    WebAPIResult_t result = webApi.SendSteamMessage(message);
+    QueuedMessage_t queuedMessage;
+    Config friendCheckConfig;
+    bool isFriendCheck;
+
+    // Wait for new messages until the extension is unloaded
+    while (messageBot.WaitForMessage(queuedMessage, friendCheckConfig, isFriendCheck)) {
+        if (isFriendCheck) {
+            // Accept new friends, but give way to the next message and stop as soon as the extension unloads
+            WebAPIResult_t result = messageBot.GetWebAPI()->AcceptFriendRequests(friendCheckConfig, []() {
+                return !messageBot.IsRunning() || messageBot.GetQueueSize() > 0;
+            });
+
+            messageBot.FinishFriendCheck(result);
+
+            continue;
+        }
+
+        std::vector<QueuedMessage_t> batch(1, queuedMessage);
+        Config &config = queuedMessage.message.config;
+
+        if (config.batchWindow > 0) {
+            // Give following messages the chance to join the batch
+            auto batchEnd = queuedMessage.queueTime + std::chrono::milliseconds(config.batchWindow);
+            auto waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(batchEnd - std::chrono::steady_clock::now()).count();
+
+            if (waitTime > 0) {
+                sleep_ms(static_cast<unsigned int>(waitTime));
+            }
+
+            messageBot.TakeBatchMessages(config, batch);
+        }
+
+        // Send messages via the shared Webapi, this is the only thread using it
+        std::vector<size_t> textIndexes;
+        std::vector<WebAPIResult_t> results = messageBot.GetWebAPI()->SendSteamMessages(config, this->MergeTexts(batch, textIndexes));
 
-    // Add callback to queue
-    messageBot.AppendCallback(std::make_shared<Callback>(this->callbackFunction, result.type, result.error));
+        // Add a callback for every single message to queue, with the result of the text it was merged into
+        for (size_t i = 0; i < batch.size(); i++) {
+            QueuedMessage_t &batchMessage = batch[i];
+            WebAPIResult_t &result = results[textIndexes[i]];
+
+            auto callback = std::make_shared<Callback>(batchMessage.callbackFunction, result.type, result.error);
+            callback->times.queueTime = batchMessage.queueTime;
+            callback->times.takeTime = batchMessage.takeTime;
+            callback->times.loginTime = result.loginTime;
+            callback->times.firstDeliveryTime = result.firstDeliveryTime;
+            callback->times.lastDeliveryTime = result.lastDeliveryTime;
+
+            messageBot.AppendCallback(callback);
+        }
+    }
+
+    // Don't leave the session open at steam, the unloading extension waits until the thread is finished
+    messageBot.GetWebAPI()->CloseSession();
 }
 
 void MessageThread::OnTerminate(IThreadHandle *pThread, bool cancel) {
-    messageBot.UnregisterAndDeleteThreadHandle(pThread);
     delete this;
+}
+
+std::vector<std::string> MessageThread::MergeTexts(std::vector<QueuedMessage_t> &batch, std::vector<size_t> &textIndexes) {
+    std::vector<std::string> texts;
+    std::string text;
+
+    textIndexes.clear();
+
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+        std::string &messageText = it->message.text;
+
+        // Start a new text if the message doesn't fit anymore
+        if (!text.empty() && text.length() + 1 + messageText.length() > MAX_MESSAGE_LENGTH) {
+            texts.push_back(text);
+            text.clear();
+        }
+
+        if (!text.empty()) {
+            text += "\n";
+        }
+
+        text += messageText;
+        textIndexes.push_back(texts.size());
+    }
+
+    texts.push_back(text);
+    return texts;
 }
\ No newline at end of file
@@ -28,21 +28,23 @@
 #define _MESSAGE_THREAD_H_
 
 #include "sdk/smsdk_ext.h"
-#include "CallbackFunction.h"
-#include "Message.h"
+#include "MessageBot.h"
 
-#include <memory>
+#include <string>
+#include <vector>
 
+/**
+ * The one and only sender thread.
+ * Runs until the extension is unloaded and sends all queued messages one after another.
+ */
 class MessageThread : public IThread {
-private:
-    Message message;
-    std::shared_ptr<CallbackFunction_t> callbackFunction;
-
 public:
-    MessageThread(Message message, std::shared_ptr<CallbackFunction_t> callbackFunction);
-
     void RunThread(IThreadHandle *pThread);
     void OnTerminate(IThreadHandle *pThread, bool cancel);
+
+private:
+    // Joins the messages to as few texts as possible, textIndexes gets the index of the text of every message
+    std::vector<std::string> MergeTexts(std::vector<QueuedMessage_t> &batch, std::vector<size_t> &textIndexes);
 };
 
 #endif
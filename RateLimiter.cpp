@@ -0,0 +1,95 @@
+/**
+ * -----------------------------------------------------
+ * File         RateLimiter.cpp
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "RateLimiter.h"
+
+#if defined _WIN32 || defined _WIN64
+#include <windows.h>
+#define sleep_ms(x) Sleep(x);
+#else
+#include <unistd.h>
+#define sleep_ms(x) usleep(x * 1000);
+#endif
+
+
+RateLimiter::RateLimiter() : interval(0), burst(1), tokens(1) {
+    this->lastRefill = std::chrono::steady_clock::now();
+}
+
+void RateLimiter::Configure(int interval, int burst) {
+    this->Refill();
+
+    this->interval = interval;
+    this->burst = burst > 0 ? burst : 1;
+
+    if (this->tokens > this->burst) {
+        this->tokens = this->burst;
+    }
+}
+
+void RateLimiter::Acquire() {
+    // No limit configured
+    if (this->interval <= 0) {
+        return;
+    }
+
+    this->Refill();
+
+    // Wait until the missing part of a token was added
+    if (this->tokens < 1) {
+        unsigned int waitTime = static_cast<unsigned int>((1 - this->tokens) * this->interval) + 1;
+        sleep_ms(waitTime);
+
+        this->Refill();
+    }
+
+    this->tokens -= 1;
+    if (this->tokens < 0) {
+        this->tokens = 0;
+    }
+}
+
+void RateLimiter::Drain() {
+    this->tokens = 0;
+    this->lastRefill = std::chrono::steady_clock::now();
+}
+
+void RateLimiter::Refill() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (this->interval > 0) {
+        double elapsed = std::chrono::duration<double, std::milli>(now - this->lastRefill).count();
+        this->tokens += elapsed / this->interval;
+    } else {
+        this->tokens = this->burst;
+    }
+
+    if (this->tokens > this->burst) {
+        this->tokens = this->burst;
+    }
+
+    this->lastRefill = now;
+}
@@ -0,0 +1,60 @@
+/**
+ * -----------------------------------------------------
+ * File         RateLimiter.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _RATE_LIMITER_H_
+#define _RATE_LIMITER_H_
+
+#include <chrono>
+
+/**
+ * Token bucket to limit requests of a specific kind.
+ * Every request takes one token, a new token is added every interval up to the burst size.
+ * Not thread safe, only the message thread is using it.
+ */
+class RateLimiter {
+private:
+    int interval;
+    int burst;
+
+    double tokens;
+    std::chrono::steady_clock::time_point lastRefill;
+
+public:
+    RateLimiter();
+
+    void Configure(int interval, int burst);
+
+    // Blocks until a token is available and takes it
+    void Acquire();
+
+    // Removes all tokens, so the next request has to wait a full interval
+    void Drain();
+
+private:
+    void Refill();
+};
+
+#endif
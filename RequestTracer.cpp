@@ -0,0 +1,123 @@
+/**
+ * -----------------------------------------------------
+ * File         RequestTracer.cpp
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "RequestTracer.h"
+#include "3rdparty/json/json/json.h"
+
+
+RequestTracer::RequestTracer() : nextTrace(0) {
+    this->traces.reserve(MAX_REQUEST_TRACES);
+}
+
+void RequestTracer::Record(RequestTrace_t &trace) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->traces.size() < MAX_REQUEST_TRACES) {
+        this->traces.push_back(trace);
+    } else {
+        this->traces[this->nextTrace] = trace;
+    }
+
+    this->nextTrace = (this->nextTrace + 1) % MAX_REQUEST_TRACES;
+}
+
+std::string RequestTracer::ToJson(size_t maxLength) {
+    std::vector<std::string> records = this->ToJsonRecords();
+
+    // Even an empty array needs the brackets
+    if (maxLength < 2) {
+        return std::string();
+    }
+
+    // Take the newest records as long as they fit together with their separator and the brackets
+    size_t count = 0;
+    size_t length = 2;
+
+    while (count < records.size()) {
+        size_t recordLength = records[count].length() + (count > 0 ? 1 : 0);
+        if (length + recordLength > maxLength) {
+            break;
+        }
+
+        length += recordLength;
+        count++;
+    }
+
+    // The records are already serialized, so only join them from old to new
+    std::string result = "[";
+    result.reserve(length);
+
+    for (auto record = records.rend() - count; record != records.rend(); record++) {
+        if (result.length() > 1) {
+            result += ",";
+        }
+
+        result += *record;
+    }
+
+    return result + "]";
+}
+
+std::vector<std::string> RequestTracer::ToJsonRecords() {
+    std::vector<std::string> records;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    records.reserve(this->traces.size());
+
+    for (size_t i = 0; i < this->traces.size(); i++) {
+        records.push_back(RequestTracer::TraceToJson(this->traces[this->GetNewestIndex(i)]));
+    }
+
+    return records;
+}
+
+size_t RequestTracer::GetNewestIndex(size_t n) {
+    // The newest trace is the one before the next one to overwrite
+    return (this->nextTrace + MAX_REQUEST_TRACES - 1 - n) % MAX_REQUEST_TRACES;
+}
+
+std::string RequestTracer::TraceToJson(RequestTrace_t &trace) {
+    Json::Value value;
+    value["step"] = trace.step;
+    value["code"] = static_cast<Json::Int>(trace.responseCode);
+    value["success"] = trace.success;
+    value["dns"] = trace.dnsTime;
+    value["connect"] = trace.connectTime;
+    value["tls"] = trace.tlsTime;
+    value["ttfb"] = trace.firstByteTime;
+    value["total"] = trace.totalTime;
+    value["bytes"] = static_cast<Json::UInt>(trace.bytesReceived);
+
+    // The writer ends every document with a line break
+    Json::FastWriter writer;
+    std::string json = writer.write(value);
+
+    if (!json.empty() && json[json.length() - 1] == '\n') {
+        json.erase(json.length() - 1);
+    }
+
+    return json;
+}
@@ -0,0 +1,80 @@
+/**
+ * -----------------------------------------------------
+ * File         RequestTracer.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _REQUEST_TRACER_H_
+#define _REQUEST_TRACER_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Number of requests kept, older ones are overwritten
+#define MAX_REQUEST_TRACES 128
+
+// Timings of a single request in milliseconds
+typedef struct {
+    std::string step;
+    long responseCode;
+    bool success;
+
+    double dnsTime;
+    double connectTime;
+    double tlsTime;
+    double firstByteTime;
+    double totalTime;
+    double bytesReceived;
+} RequestTrace_t;
+
+/**
+ * Ring buffer of the last requests with their timings.
+ * Recording and dumping is thread safe.
+ */
+class RequestTracer {
+private:
+    std::mutex mutex;
+
+    std::vector<RequestTrace_t> traces;
+    size_t nextTrace;
+
+public:
+    RequestTracer();
+
+    void Record(RequestTrace_t &trace);
+
+    // Returns the newest traces from old to new as JSON array, only as many as fit into maxLength characters
+    std::string ToJson(size_t maxLength = std::string::npos);
+
+    // Returns every trace as JSON object from new to old
+    std::vector<std::string> ToJsonRecords();
+
+private:
+    // Index of the n-th newest trace, the lock has to be held
+    size_t GetNewestIndex(size_t n);
+
+    static std::string TraceToJson(RequestTrace_t &trace);
+};
+
+#endif
@@ -1,6 +1,6 @@
 /**
  * -----------------------------------------------------
- * File         Arcfour.h
+ * File         Stats.cpp
  * Authors      David Ordnung, Impact
  * License      GPLv3
  * Web          http://dordnung.de, http://gugyclan.eu
@@ -24,21 +24,14 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>
  */
 
-#ifndef _INCLUDE_RSA_ARCFOUR_H_
-#define _INCLUDE_RSA_ARCFOUR_H_
+#include "Stats.h"
 
-#include <stdint.h>
 
-class Arcfour {
-private:
-    int i;
-    int j;
-    int S[256];
+Stats::Stats() : frameHookCalls(0), frameHookBusyCalls(0), callbacksQueued(0), callbacksTaken(0), callbacksFired(0) {}
 
-public:
-    Arcfour(uint64_t *key, int len);
+unsigned int Stats::GetCallbackQueueSize() {
+    unsigned int taken = this->callbacksTaken.load(std::memory_order_relaxed);
+    unsigned int queued = this->callbacksQueued.load(std::memory_order_relaxed);
 
-    int Next();
-};
-
-#endif
\ No newline at end of file
+    return queued > taken ? queued - taken : 0;
+}
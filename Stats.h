@@ -0,0 +1,69 @@
+/**
+ * -----------------------------------------------------
+ * File         Stats.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include "Histogram.h"
+
+#include <atomic>
+
+// Phases of a message, measured from the time it was queued
+enum LatencyPhase {
+    LatencyPhase_TAKEN,
+    LatencyPhase_LOGGED_IN,
+    LatencyPhase_FIRST_DELIVERED,
+    LatencyPhase_LAST_DELIVERED,
+    LatencyPhase_CALLBACK_FIRED,
+    LatencyPhase_MAX
+};
+
+/**
+ * Always on statistics about the costs of the extension.
+ * Class with public members, as simple getters are not meaningful.
+ */
+class Stats {
+public:
+    // Game frame hook, the time is only measured for frames with work
+    std::atomic<unsigned int> frameHookCalls;
+    std::atomic<unsigned int> frameHookBusyCalls;
+    Histogram frameHookTime;
+
+    // Callbacks passed from the message thread to the game thread
+    std::atomic<unsigned int> callbacksQueued;
+    std::atomic<unsigned int> callbacksTaken;
+    std::atomic<unsigned int> callbacksFired;
+
+    // Time in milliseconds from queuing a message until it reached a phase
+    Histogram latencies[LatencyPhase_MAX];
+
+public:
+    Stats();
+
+    unsigned int GetCallbackQueueSize();
+};
+
+#endif
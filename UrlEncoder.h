@@ -1,6 +1,6 @@
 /**
  * -----------------------------------------------------
- * File         Arcfour.cpp
+ * File         UrlEncoder.h
  * Authors      David Ordnung, Impact
  * License      GPLv3
  * Web          http://dordnung.de, http://gugyclan.eu
@@ -24,35 +24,25 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>
  */
 
-#include "Arcfour.h"
+#ifndef _URL_ENCODER_H_
+#define _URL_ENCODER_H_
 
+#include <stddef.h>
+#include <string>
 
-Arcfour::Arcfour(uint64_t *key, int len) {
-    for (int k = 0; k < 256; ++k) {
-        S[k] = k;
-    }
-
-    int l = 0;
-
-    for (int k = 0; k < 256; ++k) {
-        l = (l + S[k] + key[k % len]) & 255;
-        int t = S[k];
-
-        S[k] = S[l];
-        S[l] = t;
-    }
-
-    i = 0;
-    j = 0;
-}
+/**
+ * Percent encoding like curl_easy_escape, all but the unreserved characters of RFC 3986 are encoded.
+ * Doesn't need a curl handle and writes straight into the buffer of the caller.
+ */
+class UrlEncoder {
+public:
+    // Size of the buffer needed to encode the given number of bytes
+    static size_t GetMaxLength(size_t length);
 
-int Arcfour::Next() {
-    i = (i + 1) & 255;
-    j = (j + S[i]) & 255;
-    int t = S[i];
+    // Encodes the value into the buffer, which needs GetMaxLength(length) bytes, returns the encoded length
+    static size_t Encode(const char *value, size_t length, char *buffer);
 
-    S[i] = S[j];
-    S[j] = t;
+    static std::string Encode(const std::string &value);
+};
 
-    return S[(t + S[i]) & 255];
-}
\ No newline at end of file
+#endif
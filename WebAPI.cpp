@@ -26,18 +26,31 @@
 
 #include "WebAPI.h"
 #include "Config.h"
-#include "rsa/RSAKey.h"
+#include "UrlEncoder.h"
 
 #include <chrono>
-#include <stdarg.h>
 #include <string.h>
 #include <algorithm>
 #include <random>
 #include <fstream>
+#include <mutex>
+#include <unordered_set>
 
 #define CLIENT_ID "DE45CD61"
 #define CLIENT_SCOPE "read_profile write_profile read_client write_client"
 
+// Maximum number of requests running at the same time
+#define MAX_PARALLEL_REQUESTS 8
+
+// Maximum number of steamids steam accepts for one user summary request
+#define MAX_USERS_PER_SUMMARY 100
+
+// Maximum time in seconds for the logout when the extension unloads
+#define CLOSE_SESSION_TIMEOUT 2
+
+// Response buffers above this size are released after use instead of being kept for the next request
+#define MAX_KEPT_RESPONSE_SIZE (1024 * 1024)
+
 #define USER_AGENT_APP "Steam App / Android / 2.3.1 / 3922515"
 #define USER_AGENT_ANDROID "Mozilla/5.0 (Linux; U; Android; en-gb;) AppleWebKit/534.30 (KHTML, like Gecko) Version/4.0 Mobile Safari/534.30"
 
@@ -47,12 +60,6 @@
 #define STEAM_LOGIN_SECURE_COOKIE "steamLoginSecure=null%7C%7Cnull; path=/; domain=steamcommunity.com; secure"
 #define STEAM_LOGIN_COOKIE "steamLogin=null%7C%7Cnull; path=/; domain=steamcommunity.com; secure"
 
-#if defined _WIN32 || defined _WIN64
-#define sleep_ms(x) Sleep(x);
-#else
-#define sleep_ms(x) usleep(x * 1000);
-#endif
-
 // Use server console if sourcemod build, otherwise use printf
 #if defined SOURCEMOD_BUILD
 #include "MessageBot.h"
@@ -60,13 +67,28 @@
 #define Debug(fmt, ...) if (this->debugEnabled) smutils->LogMessage(myself, fmt, ##__VA_ARGS__)
 #else
 #define LogError(fmt, ...) printf(fmt, ##__VA_ARGS__)
-#define Debug(fmt, ...) if (this->debugEnabled) printf(fmt ## "\n", ##__VA_ARGS__)
+#define Debug(fmt, ...) if (this->debugEnabled) printf(fmt "\n", ##__VA_ARGS__)
 #endif
 
 
-WebAPI::WebAPI() : debugEnabled(false), requestTimeout(0), webAPIClient(nullptr), steamCommunityClient(nullptr) {
+// Locks for the data of the share handle, as it may be used by different threads
+static std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+
+static void LockShare(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    shareLocks[data].lock();
+}
+
+static void UnlockShare(CURL *handle, curl_lock_data data, void *userptr) {
+    shareLocks[data].unlock();
+}
+
+WebAPI::WebAPI(CURLSH *shareClient) : debugEnabled(false), requestTimeout(0), webAPIClient(nullptr), steamCommunityClient(nullptr), multiClient(nullptr),
+    shareClient(shareClient), sessionExpired(false), presenceCacheHits(0), presenceCacheMisses(0) {
     this->steamCommunityClient = curl_easy_init();
     this->webAPIClient = curl_easy_init();
+    this->multiClient = curl_multi_init();
+
+    this->session.loggedIn = false;
 }
 
 WebAPI::~WebAPI() {
@@ -77,6 +99,14 @@ WebAPI::~WebAPI() {
     if (this->webAPIClient) {
         curl_easy_cleanup(this->webAPIClient);
     }
+
+    for (auto client = this->parallelClients.begin(); client != this->parallelClients.end(); client++) {
+        curl_easy_cleanup(*client);
+    }
+
+    if (this->multiClient) {
+        curl_multi_cleanup(this->multiClient);
+    }
 }
 
 Json::Value WebAPI::LoginSteamCommunity(std::string username, std::string password) {
@@ -91,45 +121,53 @@ Json::Value WebAPI::LoginSteamCommunity(std::string username, std::string passwo
     this->AddCookie(this->steamCommunityClient, LANGUAGE_COOKIE);
 
     // Notify steam that we need oauth
-    std::string sessionPage = "https://steamcommunity.com/mobilelogin?oauth_client_id=" + this->urlencode(CLIENT_ID) + "&oauth_scope=" + this->urlencode(CLIENT_SCOPE);
+    std::string sessionPage = this->steamCommunityUrl + "/mobilelogin?oauth_client_id=" + UrlEncoder::Encode(CLIENT_ID) + "&oauth_scope=" + UrlEncoder::Encode(CLIENT_SCOPE);
 
-    WriteDataInfo pageInfo = this->GetPage(this->steamCommunityClient, sessionPage, USER_AGENT_ANDROID, nullptr);
-    if (!pageInfo.error.empty()) {
+    WriteDataInfo &sessionInfo = this->GetPage(this->steamCommunityClient, "mobilelogin", sessionPage, USER_AGENT_ANDROID, nullptr);
+    if (!sessionInfo.error.empty()) {
         result["success"] = false;
-        result["error"] = "Failed to receive SteamCommunity RSA key. Error: '" + pageInfo.error + "'";
+        result["error"] = "Failed to receive SteamCommunity RSA key. Error: '" + sessionInfo.error + "'";
         return result;
     }
 
     // Get the RSA key to login
     long long time = std::chrono::system_clock::now().time_since_epoch().count();
-    pageInfo = this->GetPage(this->steamCommunityClient, "https://steamcommunity.com/mobilelogin/getrsakey", USER_AGENT_ANDROID,
-                             "username=%s&donotcache=%lld", const_cast<char *>(this->urlencode(username).c_str()), time);
+    this->form.Clear().Add("username", username).AddInt("donotcache", time);
+    WriteDataInfo &keyInfo = this->GetPage(this->steamCommunityClient, "getrsakey", this->steamCommunityUrl + "/mobilelogin/getrsakey", USER_AGENT_ANDROID, &this->form);
 
     // Check for errors
-    if (!pageInfo.error.empty()) {
+    if (!keyInfo.error.empty()) {
         result["success"] = false;
-        result["error"] = "Failed to receive SteamCommunity RSA key. Error: '" + pageInfo.error + "'";
+        result["error"] = "Failed to receive SteamCommunity RSA key. Error: '" + keyInfo.error + "'";
         return result;
     }
 
-    result.clear();
-    if (!reader.parse(pageInfo.content, result)) {
-        result["success"] = false;
-        result["error"] = "Failed to parse SteamCommunity RSA key. Error: '" + reader.getFormattedErrorMessages() + "'";
-        return result;
-    }
+    // Read RSA information, the parsed response is released at once with its arena
+    std::string mod;
+    std::string exp;
+    std::string timestamp;
+    std::string error;
 
-    if (!result.get("success", false).asBool()) {
-        std::string json = result.toStyledString();
+    {
+        Json::ValueArena arena;
+        Json::Value response;
 
-        result["error"] = "Failed to get SteamCommunity RSA key. JSON: '" + json + "'";
-        return result;
+        if (!reader.parse(keyInfo.content.data(), keyInfo.content.data() + keyInfo.content.length(), response)) {
+            error = "Failed to parse SteamCommunity RSA key. Error: '" + reader.getFormattedErrorMessages() + "'";
+        } else if (!response.get("success", false).asBool()) {
+            error = "Failed to get SteamCommunity RSA key. JSON: '" + response.toStyledString() + "'";
+        } else {
+            mod = response.get("publickey_mod", "").asString();
+            exp = response.get("publickey_exp", "").asString();
+            timestamp = response.get("timestamp", "").asString();
+        }
     }
 
-    // Read RSA information
-    std::string mod = result.get("publickey_mod", "").asString();
-    std::string exp = result.get("publickey_exp", "").asString();
-    std::string timestamp = result.get("timestamp", "").asString();
+    if (!error.empty()) {
+        result["success"] = false;
+        result["error"] = error;
+        return result;
+    }
 
     if (mod.empty() || exp.empty() || timestamp.empty()) {
         result["success"] = false;
@@ -137,54 +175,76 @@ Json::Value WebAPI::LoginSteamCommunity(std::string username, std::string passwo
         return result;
     }
 
-    // Now encrypt it with RSA
-    RSAKey rsaKey(mod.c_str(), exp.c_str());
-    std::string encrypted = rsaKey.Encrypt(password.c_str());
+    // Parse the key only if steam returned a new one, the timestamp identifies it on login
+    if (!this->rsaKey.key || this->rsaKey.timestamp != timestamp || this->rsaKey.mod != mod || this->rsaKey.exp != exp) {
+        this->rsaKey.timestamp = timestamp;
+        this->rsaKey.mod = mod;
+        this->rsaKey.exp = exp;
+        this->rsaKey.key = std::make_shared<RSAKey>(mod, exp);
+        this->rsaKey.password.clear();
+        this->rsaKey.encryptedPassword.clear();
+    } else {
+        Debug("[DEBUG] Reusing the RSA key with timestamp %s", timestamp.c_str());
+    }
 
-    // And login with it
-    pageInfo = this->GetPage(this->steamCommunityClient, "https://steamcommunity.com/mobilelogin/dologin/", USER_AGENT_ANDROID,
-                             "donotcache=%lld&password=%s&username=%s&twofactorcode=&emailauth=&loginfriendlyname=CallAdmin&captchagid=-1&captcha_text=&emailsteamid=&rsatimestamp=%s&remember_login=true&oauth_client_id=%s",
-                             time, this->urlencode(encrypted).c_str(), this->urlencode(username).c_str(), timestamp.c_str(), CLIENT_ID);
+    // Now encrypt it with RSA, the encrypted password stays valid as long as the key
+    if (this->rsaKey.encryptedPassword.empty() || this->rsaKey.password != password) {
+        this->rsaKey.password = password;
+        this->rsaKey.encryptedPassword = this->rsaKey.key->Encrypt(password);
 
-    // Check for errors
-    if (!pageInfo.error.empty()) {
-        result["success"] = false;
-        result["error"] = "Failed to login. Error: '" + pageInfo.error + "'";
-        return result;
+        if (this->rsaKey.encryptedPassword.empty()) {
+            result["success"] = false;
+            result["error"] = "Failed to encrypt the password with the SteamCommunity RSA key (" + mod + ", " + exp + ")";
+            return result;
+        }
     }
 
-    result.clear();
-    if (!reader.parse(pageInfo.content, result)) {
-        result["success"] = false;
-        result["error"] = "Failed to parse login result. Error: '" + reader.getFormattedErrorMessages() + "'";
-        return result;
-    }
+    std::string encrypted = this->rsaKey.encryptedPassword;
+
+    // And login with it
+    this->form.Clear().AddInt("donotcache", time).Add("password", encrypted).Add("username", username).Add("twofactorcode", "").Add("emailauth", "");
+    this->form.Add("loginfriendlyname", "CallAdmin").Add("captchagid", "-1").Add("captcha_text", "").Add("emailsteamid", "").Add("rsatimestamp", timestamp);
+    this->form.Add("remember_login", "true").Add("oauth_client_id", CLIENT_ID);
 
-    if (!result.get("success", false).asBool() || !result.get("login_complete", false).asBool()) {
-        std::string json = result.toStyledString();
+    WriteDataInfo &loginInfo = this->GetPage(this->steamCommunityClient, "dologin", this->steamCommunityUrl + "/mobilelogin/dologin/", USER_AGENT_ANDROID, &this->form);
 
+    // Check for errors
+    if (!loginInfo.error.empty()) {
         result["success"] = false;
-        result["error"] = "Failed to successfully login. JSON: '" + json + "'";
+        result["error"] = "Failed to login. Error: '" + loginInfo.error + "'";
         return result;
     }
 
-    // Read oauth from result
-    std::string auth = result.get("oauth", "").asString();
-    if (auth.empty()) {
-        result["success"] = false;
-        result["error"] = "Got empty oauth!";
-        return result;
+    // Read oauth from the login result and from there the steamid and oauth token
+    std::string auth;
+    std::string steamId;
+    std::string oauthToken;
+
+    {
+        Json::ValueArena arena;
+        Json::Value response;
+
+        if (!reader.parse(loginInfo.content.data(), loginInfo.content.data() + loginInfo.content.length(), response)) {
+            error = "Failed to parse login result. Error: '" + reader.getFormattedErrorMessages() + "'";
+        } else if (!response.get("success", false).asBool() || !response.get("login_complete", false).asBool()) {
+            error = "Failed to successfully login. JSON: '" + response.toStyledString() + "'";
+        } else if ((auth = response.get("oauth", "").asString()).empty()) {
+            error = "Got empty oauth!";
+        } else if (!reader.parse(auth.data(), auth.data() + auth.length(), response)) {
+            error = "Failed to parse oauth token. Error: '" + reader.getFormattedErrorMessages() + "'";
+        } else {
+            steamId = response.get("steamid", "").asString();
+            oauthToken = response.get("oauth_token", "").asString();
+        }
     }
 
-    result.clear();
-    if (!reader.parse(auth, result)) {
+    if (!error.empty()) {
         result["success"] = false;
-        result["error"] = "Failed to parse oauth token. Error: '" + reader.getFormattedErrorMessages() + "'";
+        result["error"] = error;
         return result;
     }
 
-    // And from there read steamid and oauth token
-    if (result.get("steamid", "").asString().empty() || result.get("oauth_token", "").asString().empty()) {
+    if (steamId.empty() || oauthToken.empty()) {
         result["success"] = false;
         result["error"] = "Failed to get login steamid or oauth. Got: '" + auth + "'";
         return result;
@@ -192,6 +252,8 @@ Json::Value WebAPI::LoginSteamCommunity(std::string username, std::string passwo
 
     Debug("[DEBUG] Logged in succesfully");
 
+    result["steamid"] = steamId;
+    result["oauth_token"] = oauthToken;
     result["success"] = true;
     return result;
 }
@@ -200,11 +262,10 @@ Json::Value WebAPI::LoginWebAPI(std::string accessToken) {
     Debug("[DEBUG] Trying to login to the web API");
 
     Json::Value result;
-    Json::Reader reader;
 
     // Login to get UMQID
-    WriteDataInfo pageInfo = this->GetPage(this->webAPIClient, "https://api.steampowered.com/ISteamWebUserPresenceOAuth/Logon/v0001",
-                                           USER_AGENT_APP, "access_token=%s", accessToken.c_str());
+    this->form.Clear().Add("access_token", accessToken);
+    WriteDataInfo &pageInfo = this->GetPage(this->webAPIClient, "Logon", this->webApiUrl + "/ISteamWebUserPresenceOAuth/Logon/v0001", USER_AGENT_APP, &this->form);
 
     // Valid result?
     if (!pageInfo.error.empty()) {
@@ -213,31 +274,45 @@ Json::Value WebAPI::LoginWebAPI(std::string accessToken) {
         return result;
     }
 
-    result.clear();
-    if (!reader.parse(pageInfo.content, result)) {
+    // Only the error and the UMQID are needed
+    std::string error;
+    std::string umqid;
+
+    JsonCursor json(pageInfo.content);
+    if (json.EnterObject()) {
+        std::string key;
+
+        while (json.NextKey(key)) {
+            if (key == "error") {
+                json.ReadString(error);
+            } else if (key == "umqid") {
+                json.ReadString(umqid);
+            } else {
+                json.Skip();
+            }
+        }
+    }
+
+    if (json.HasFailed()) {
         result["success"] = false;
-        result["error"] = "Failed to parse UMQID. Error: '" + reader.getFormattedErrorMessages() + "'";
+        result["error"] = "Failed to parse UMQID. JSON: '" + pageInfo.content + "'";
         return result;
     }
 
-    std::string error = result.get("error", "").asString();
     if (error != "OK") {
         result["success"] = false;
         result["error"] = "Failed to get UMQID. Error: '" + error + "'";
         return result;
     }
 
-    // Parse UMQID
-    std::string umqid = result.get("umqid", "").asString();
     if (umqid.empty()) {
-        std::string json = result.toStyledString();
-
         result["success"] = false;
-        result["error"] = "Got empty UMQID. JSON: '" + json + "'";
+        result["error"] = "Got empty UMQID. JSON: '" + pageInfo.content + "'";
         return result;
     }
 
     Debug("[DEBUG] Got UMQID");
+    result["umqid"] = umqid;
     result["success"] = true;
     return result;
 }
@@ -250,23 +325,22 @@ void WebAPI::LogoutWebAPI() {
     this->AddCookie(this->steamCommunityClient, STEAM_LOGIN_COOKIE);
 
     // Just go back to session page with cookies notifying logout
-    std::string sessionPage = "https://steamcommunity.com/mobilelogin?oauth_client_id=" + this->urlencode(CLIENT_ID) + "&oauth_scope=" + this->urlencode(CLIENT_SCOPE);
-    this->GetPage(this->steamCommunityClient, sessionPage, USER_AGENT_ANDROID, nullptr);
+    std::string sessionPage = this->steamCommunityUrl + "/mobilelogin?oauth_client_id=" + UrlEncoder::Encode(CLIENT_ID) + "&oauth_scope=" + UrlEncoder::Encode(CLIENT_SCOPE);
+    this->GetPage(this->steamCommunityClient, "logout", sessionPage, USER_AGENT_ANDROID, nullptr);
 
     Debug("[DEBUG] Logged out");
 }
 
-Json::Value WebAPI::GetFriendList(std::string accessToken) {
+Json::Value WebAPI::GetFriendList(std::string accessToken, std::vector<uint64_t> &friends, std::vector<uint64_t> &friendRequests) {
     Debug("[DEBUG] Trying to get friend list");
 
     Json::Value result;
-    Json::Reader reader;
 
-    std::string url = "https://api.steampowered.com/ISteamUserOAuth/GetFriendList/v0001";
+    std::string url = this->webApiUrl + "/ISteamUserOAuth/GetFriendList/v0001";
     url = url + "?access_token=" + accessToken + "&relationship=friend,requestrecipient";
 
     // Read the friend list of the bot
-    WriteDataInfo pageInfo = this->GetPage(this->webAPIClient, url, USER_AGENT_APP, nullptr);
+    WriteDataInfo &pageInfo = this->GetPage(this->webAPIClient, "GetFriendList", url, USER_AGENT_APP, nullptr);
 
     // Valid result?
     if (!pageInfo.error.empty()) {
@@ -275,10 +349,54 @@ Json::Value WebAPI::GetFriendList(std::string accessToken) {
         return result;
     }
 
-    result.clear();
-    if (!reader.parse(pageInfo.content, result)) {
+    this->CheckSessionExpired(pageInfo, "");
+    if (this->sessionExpired) {
         result["success"] = false;
-        result["error"] = "Failed to parse friend list. Error: '" + reader.getFormattedErrorMessages() + "'";
+        result["error"] = "Failed to receive friend list. Session expired";
+        return result;
+    }
+
+    // Read the steamid and relationship of every friend without building the whole friend list
+    JsonCursor json(pageInfo.content);
+    if (json.EnterObject()) {
+        std::string key;
+
+        while (json.NextKey(key)) {
+            if (key != "friends" || !json.EnterArray()) {
+                json.Skip();
+                continue;
+            }
+
+            while (json.NextElement()) {
+                if (!json.EnterObject()) {
+                    continue;
+                }
+
+                uint64_t steamId = 0;
+                std::string relationship;
+
+                while (json.NextKey(key)) {
+                    if (key == "steamid") {
+                        json.ReadUInt64(steamId);
+                    } else if (key == "relationship") {
+                        json.ReadString(relationship);
+                    } else {
+                        json.Skip();
+                    }
+                }
+
+                if (relationship == "friend") {
+                    friends.push_back(steamId);
+                } else if (relationship == "requestrecipient") {
+                    friendRequests.push_back(steamId);
+                }
+            }
+        }
+    }
+
+    if (json.HasFailed()) {
+        result["success"] = false;
+        result["error"] = "Failed to parse friend list. JSON: '" + pageInfo.content + "'";
         return result;
     }
 
@@ -288,41 +406,95 @@ Json::Value WebAPI::GetFriendList(std::string accessToken) {
 }
 
 
-Json::Value WebAPI::GetUserStats(std::string accessToken, std::vector<uint64_t> &users) {
+Json::Value WebAPI::GetUserStats(std::string accessToken, std::vector<uint64_t> &users, std::vector<PlayerSummary_t> &players) {
     Debug("[DEBUG] Trying to get user stats");
 
     Json::Value result;
-    Json::Reader reader;
 
-    std::string url = "https://api.steampowered.com/ISteamUserOAuth/GetUserSummaries/v0001";
-    url = url + "?access_token=" + accessToken + "&steamids=";
+    // Steam only allows a limited number of users per request, so split them up
+    std::vector<PageRequest> requests;
+    for (size_t i = 0; i < users.size(); i += MAX_USERS_PER_SUMMARY) {
+        PageRequest request;
+        request.step = "GetUserSummaries";
+        request.url = this->webApiUrl + "/ISteamUserOAuth/GetUserSummaries/v0001";
+        request.url = request.url + "?access_token=" + accessToken + "&steamids=";
+        request.postData = nullptr;
+
+        // Append the users of this chunk to the request
+        size_t end = (std::min)(users.size(), i + MAX_USERS_PER_SUMMARY);
+        for (size_t j = i; j < end; j++) {
+            if (j != i) {
+                request.url += ",";
+            }
 
-    // Append all users to the request
-    bool isFirst = true;
-    for (auto user = users.begin(); user != users.end(); user++) {
-        if (isFirst) {
-            isFirst = false;
-            url = url + std::to_string(*user);
-        } else {
-            url = url + "," + std::to_string(*user);
+            request.url += std::to_string(users[j]);
         }
+
+        requests.push_back(request);
     }
 
-    // Get user stats of all users
-    WriteDataInfo pageInfo = this->GetPage(this->webAPIClient, url, USER_AGENT_APP, nullptr);
+    // Get user stats of all users at the same time
+    this->GetPages(requests, USER_AGENT_APP);
 
-    // Valid result?
-    if (!pageInfo.error.empty()) {
-        result["success"] = false;
-        result["error"] = "Failed to receive user stats. Error: '" + pageInfo.error + "'";
-        return result;
-    }
+    for (size_t i = 0; i < requests.size(); i++) {
+        WriteDataInfo &pageInfo = this->pageResponses[i];
 
-    result.clear();
-    if (!reader.parse(pageInfo.content, result)) {
-        result["success"] = false;
-        result["error"] = "Failed to parse user stats. Error: '" + reader.getFormattedErrorMessages() + "'";
-        return result;
+        // Valid result?
+        if (!pageInfo.error.empty()) {
+            result["success"] = false;
+            result["error"] = "Failed to receive user stats. Error: '" + pageInfo.error + "'";
+            return result;
+        }
+
+        this->CheckSessionExpired(pageInfo, "");
+        if (this->sessionExpired) {
+            result["success"] = false;
+            result["error"] = "Failed to receive user stats. Session expired";
+            return result;
+        }
+
+        // Merge the players of all chunks, only the steamid and the persona state are needed
+        JsonCursor json(pageInfo.content);
+        if (json.EnterObject()) {
+            std::string key;
+
+            while (json.NextKey(key)) {
+                if (key != "players" || !json.EnterArray()) {
+                    json.Skip();
+                    continue;
+                }
+
+                while (json.NextElement()) {
+                    if (!json.EnterObject()) {
+                        continue;
+                    }
+
+                    PlayerSummary_t player;
+                    player.steamId = 0;
+                    player.personaState = 0;
+
+                    while (json.NextKey(key)) {
+                        int64_t personaState;
+
+                        if (key == "steamid") {
+                            json.ReadUInt64(player.steamId);
+                        } else if (key == "personastate" && json.ReadInt(personaState)) {
+                            player.personaState = static_cast<int>(personaState);
+                        } else if (key != "personastate") {
+                            json.Skip();
+                        }
+                    }
+
+                    players.push_back(player);
+                }
+            }
+        }
+
+        if (json.HasFailed()) {
+            result["success"] = false;
+            result["error"] = "Failed to parse user stats. JSON: '" + pageInfo.content + "'";
+            return result;
+        }
     }
 
     Debug("[DEBUG] Got user stats");
@@ -338,9 +510,9 @@ Json::Value WebAPI::AcceptFriend(std::string sessionId, std::string ownSteamId,
     Json::Reader reader;
 
     // Accept the friend with a AJAX request
-    std::string url = "https://steamcommunity.com/profiles/" + ownSteamId + "/friends/action";
-    WriteDataInfo pageInfo = this->GetPage(this->steamCommunityClient, url, USER_AGENT_ANDROID,
-                                           "sessionid=%s&steamid=%s&ajax=1&action=accept&steamids[]=%s", sessionId.c_str(), ownSteamId.c_str(), friendSteamId.c_str());
+    std::string url = this->steamCommunityUrl + "/profiles/" + ownSteamId + "/friends/action";
+    this->form.Clear().Add("sessionid", sessionId).Add("steamid", ownSteamId).Add("ajax", "1").Add("action", "accept").Add("steamids[]", friendSteamId);
+    WriteDataInfo &pageInfo = this->GetPage(this->steamCommunityClient, "AcceptFriend", url, USER_AGENT_ANDROID, &this->form);
 
     // Valid result?
     if (!pageInfo.error.empty()) {
@@ -349,18 +521,23 @@ Json::Value WebAPI::AcceptFriend(std::string sessionId, std::string ownSteamId,
         return result;
     }
 
-    result.clear();
-    if (!reader.parse(pageInfo.content, result)) {
-        result["success"] = false;
-        result["error"] = "Failed to parse friend accept. Error: '" + reader.getFormattedErrorMessages() + "'";
-        return result;
-    }
+    // The parsed response is released at once with its arena
+    std::string error;
+
+    {
+        Json::ValueArena arena;
+        Json::Value response;
 
-    if (result.get("success", false).asInt() != 1) {
-        std::string json = result.toStyledString();
+        if (!reader.parse(pageInfo.content.data(), pageInfo.content.data() + pageInfo.content.length(), response)) {
+            error = "Failed to parse friend accept. Error: '" + reader.getFormattedErrorMessages() + "'";
+        } else if (response.get("success", false).asInt() != 1) {
+            error = "Failed to accept friend. JSON: '" + response.toStyledString() + "'";
+        }
+    }
 
+    if (!error.empty()) {
         result["success"] = false;
-        result["error"] = "Failed to accept friend. JSON: '" + json + "'";
+        result["error"] = error;
         return result;
     }
 
@@ -372,13 +549,47 @@ Json::Value WebAPI::AcceptFriend(std::string sessionId, std::string ownSteamId,
 Json::Value WebAPI::SendSteamMessage(std::string accessToken, std::string umqid, uint64_t steamid, std::string text) {
     Debug("[DEBUG] Trying to send a message to '%lld'", steamid);
 
-    Json::Value result;
-    Json::Reader reader;
-
     // Send the message
-    WebAPI::WriteDataInfo pageInfo = this->GetPage(this->webAPIClient, "https://api.steampowered.com/ISteamWebUserPresenceOAuth/Message/v0001",
-                                                   USER_AGENT_APP, "access_token=%s&umqid=%s&type=saytext&steamid_dst=%lld&text=%s",
-                                                   accessToken.c_str(), umqid.c_str(), steamid, urlencode(text).c_str());
+    this->form.Clear().Add("access_token", accessToken).Add("umqid", umqid).Add("type", "saytext").AddUInt("steamid_dst", steamid).Add("text", text);
+    WebAPI::WriteDataInfo &pageInfo = this->GetPage(this->webAPIClient, "Message", this->webApiUrl + "/ISteamWebUserPresenceOAuth/Message/v0001", USER_AGENT_APP, &this->form);
+
+    return this->ParseSendMessageResult(pageInfo);
+}
+
+std::vector<Json::Value> WebAPI::SendSteamMessageParallel(std::string accessToken, std::string umqid, std::vector<uint64_t> &steamids, std::string text) {
+    Debug("[DEBUG] Trying to send a message to %d recipients at once", static_cast<int>(steamids.size()));
+
+    // Build one request for every recipient, the bodies are only added, never removed
+    if (this->parallelForms.size() < steamids.size()) {
+        this->parallelForms.resize(steamids.size());
+    }
+
+    std::vector<PageRequest> requests;
+    for (size_t i = 0; i < steamids.size(); i++) {
+        FormBody &form = this->parallelForms[i];
+        form.Clear().Add("access_token", accessToken).Add("umqid", umqid).Add("type", "saytext").AddUInt("steamid_dst", steamids[i]).Add("text", text);
+
+        PageRequest request;
+        request.step = "Message";
+        request.url = this->webApiUrl + "/ISteamWebUserPresenceOAuth/Message/v0001";
+        request.postData = &form;
+
+        requests.push_back(request);
+    }
+
+    // Send all messages at the same time
+    this->GetPages(requests, USER_AGENT_APP);
+
+    std::vector<Json::Value> results;
+    for (size_t i = 0; i < requests.size(); i++) {
+        results.push_back(this->ParseSendMessageResult(this->pageResponses[i]));
+    }
+
+    return results;
+}
+
+Json::Value WebAPI::ParseSendMessageResult(WriteDataInfo &pageInfo) {
+    Json::Value result;
 
     // Valid result?
     if (!pageInfo.error.empty()) {
@@ -387,15 +598,38 @@ Json::Value WebAPI::SendSteamMessage(std::string accessToken, std::string umqid,
         return result;
     }
 
-    result.clear();
-    if (!reader.parse(pageInfo.content, result)) {
+    this->CheckSessionExpired(pageInfo, "");
+    if (this->sessionExpired) {
         result["success"] = false;
-        result["error"] = "Failed to parse sent message result. Error: '" + reader.getFormattedErrorMessages() + "'";
+        result["error"] = "Failed to send message. Session expired";
+        return result;
+    }
+
+    // Only the error is needed
+    std::string error;
+
+    JsonCursor json(pageInfo.content);
+    if (json.EnterObject()) {
+        std::string key;
+
+        while (json.NextKey(key)) {
+            if (key == "error") {
+                json.ReadString(error);
+            } else {
+                json.Skip();
+            }
+        }
+    }
+
+    if (json.HasFailed()) {
+        result["success"] = false;
+        result["error"] = "Failed to parse sent message result. JSON: '" + pageInfo.content + "'";
         return result;
     }
 
-    std::string error = result.get("error", "").asString();
     if (error != "OK") {
+        this->CheckSessionExpired(pageInfo, error);
+
         result["success"] = false;
         result["error"] = "Failed to send message. Error: '" + error + "'";
         return result;
@@ -407,12 +641,14 @@ Json::Value WebAPI::SendSteamMessage(std::string accessToken, std::string umqid,
 }
 
 WebAPIResult_t WebAPI::SendSteamMessage(Message message) {
-    this->debugEnabled = message.config.debugEnabled;
-    this->requestTimeout = message.config.requestTimeout;
+    return this->SendSteamMessages(message.config, std::vector<std::string>(1, message.text)).front();
+}
 
+std::vector<WebAPIResult_t> WebAPI::SendSteamMessages(Config config, std::vector<std::string> texts) {
+    this->ApplyConfig(config);
 
-    std::vector<uint64_t> recipientsCopy(message.config.recipients);
-    if (message.config.shuffleRecipients) {
+    std::vector<uint64_t> recipientsCopy(config.recipients);
+    if (config.shuffleRecipients) {
         std::random_device randomDevice;
         std::mt19937 randomEngine(randomDevice());
 
@@ -420,7 +656,9 @@ WebAPIResult_t WebAPI::SendSteamMessage(Message message) {
         Debug("[DEBUG] Shuffled recipient list");
     }
 
-    Debug("[DEBUG] Trying to send a message as user '%s' with password '%s' and message '%s'", message.config.username.c_str(), message.config.password.c_str(), message.text.c_str());
+    for (auto text = texts.begin(); text != texts.end(); text++) {
+        Debug("[DEBUG] Trying to send a message as user '%s' with password '%s' and message '%s'", config.username.c_str(), config.password.c_str(), text->c_str());
+    }
 
     WebAPIResult_t result;
 
@@ -430,10 +668,96 @@ WebAPIResult_t WebAPI::SendSteamMessage(Message message) {
 
         result.type = WebAPIResult_NO_RECEIVER;
         result.error = "No receiver was configurated";
+        return std::vector<WebAPIResult_t>(texts.size(), result);
+    }
+
+    this->CheckSession(config);
+
+    // Recipients which already got a text and the result of every text, both are kept for the retry
+    std::vector<std::unordered_set<uint64_t>> delivered(texts.size());
+
+    // A text is only successful after it reached all online recipients
+    WebAPIResult_t pendingResult;
+    pendingResult.type = WebAPIResult_API_ERROR;
+    std::vector<WebAPIResult_t> textResults(texts.size(), pendingResult);
+
+    result = this->DeliverMessage(config, texts, recipientsCopy, delivered, textResults);
+
+    // Steam invalidated the session in the meantime, so login again and retry once, but only for the recipients which didn't get the text yet
+    if (result.type != WebAPIResult_SUCCESS && this->sessionExpired) {
+        Debug("[DEBUG] Session expired, trying to login again");
+        this->InvalidateSession();
+
+        result = this->DeliverMessage(config, texts, recipientsCopy, delivered, textResults);
+    }
+
+    // Every text which didn't reach all online recipients failed because of the error which stopped the delivery
+    for (auto textResult = textResults.begin(); textResult != textResults.end(); textResult++) {
+        textResult->loginTime = result.loginTime;
+
+        if (textResult->type != WebAPIResult_SUCCESS) {
+            textResult->type = result.type;
+            textResult->error = result.error;
+        }
+    }
+
+    return textResults;
+}
+
+WebAPIResult_t WebAPI::AcceptFriendRequests(Config config, std::function<bool()> isInterrupted) {
+    this->ApplyConfig(config);
+
+    WebAPIResult_t result;
+
+    // Without credentials there is no account to manage
+    if (config.username.empty()) {
+        result.type = WebAPIResult_LOGIN_ERROR;
+        result.error = "No login data was configurated";
         return result;
     }
 
-    Json::Value loginSteamCommunityResult = this->LoginSteamCommunity(message.config.username, message.config.password);
+    this->CheckSession(config);
+
+    result = this->UpdateFriends(config, isInterrupted);
+
+    // Steam invalidated the session in the meantime, so login again and retry once
+    if (result.type != WebAPIResult_SUCCESS && this->sessionExpired) {
+        Debug("[DEBUG] Session expired, trying to login again");
+        this->InvalidateSession();
+
+        result = this->UpdateFriends(config, isInterrupted);
+    }
+
+    return result;
+}
+
+void WebAPI::ApplyConfig(Config &config) {
+    this->debugEnabled = config.debugEnabled;
+    this->requestTimeout = config.requestTimeout;
+    this->steamCommunityUrl = config.steamCommunityUrl;
+    this->webApiUrl = config.webApiUrl;
+
+    this->loginLimiter.Configure(config.waitAfterLogout, config.loginBurst);
+    this->communityLimiter.Configure(config.waitBetweenCommunityRequests, config.communityBurst);
+    this->messageLimiter.Configure(config.waitBetweenMessages, config.messageBurst);
+}
+
+void WebAPI::CheckSession(Config &config) {
+    // The current session belongs to other credentials or is already known as invalid, so it can't be reused
+    if (this->sessionExpired) {
+        this->InvalidateSession();
+    } else if (this->session.loggedIn && (this->session.username != config.username || this->session.password != config.password)) {
+        Debug("[DEBUG] Login data changed, closing current session");
+        this->Logout();
+    }
+}
+
+WebAPIResult_t WebAPI::Login(Config &config) {
+    WebAPIResult_t result;
+
+    this->loginLimiter.Acquire();
+
+    Json::Value loginSteamCommunityResult = this->LoginSteamCommunity(config.username, config.password);
     if (!loginSteamCommunityResult["success"].asBool()) {
         LogError(loginSteamCommunityResult["error"].asString().c_str());
 
@@ -443,121 +767,376 @@ WebAPIResult_t WebAPI::SendSteamMessage(Message message) {
     }
 
     std::string accessToken = loginSteamCommunityResult["oauth_token"].asString();
-    std::string steamid = loginSteamCommunityResult["steamid"].asString();
-    std::string sessionid = this->GetCookie(this->steamCommunityClient, "sessionid");
 
     Json::Value loginWebAPIResult = this->LoginWebAPI(accessToken);
     if (!loginWebAPIResult["success"].asBool()) {
         LogError(loginWebAPIResult["error"].asString().c_str());
 
         result.type = WebAPIResult_LOGIN_ERROR;
-        result.error = loginSteamCommunityResult["error"].asString();
+        result.error = loginWebAPIResult["error"].asString();
         return result;
     }
 
-    std::string umqid = loginWebAPIResult["umqid"].asString();
+    // The known friends belong to another account
+    if (this->session.username != config.username) {
+        this->friends.clear();
+    }
 
-    // Get friend list
-    Json::Value friendListResult = this->GetFriendList(accessToken);
-    if (!friendListResult["success"].asBool()) {
-        LogError(friendListResult["error"].asString().c_str());
+    // Remember the session for the next messages
+    this->session.loggedIn = true;
+    this->session.username = config.username;
+    this->session.password = config.password;
+    this->session.accessToken = accessToken;
+    this->session.steamId = loginSteamCommunityResult["steamid"].asString();
+    this->session.sessionId = this->GetCookie(this->steamCommunityClient, "sessionid");
+    this->session.umqid = loginWebAPIResult["umqid"].asString();
 
-        result.type = WebAPIResult_API_ERROR;
-        result.error = loginSteamCommunityResult["error"].asString();
-        return result;
+    result.type = WebAPIResult_SUCCESS;
+    result.error = std::string();
+    return result;
+}
+
+void WebAPI::Logout() {
+    if (this->session.loggedIn) {
+        this->LogoutWebAPI();
+
+        // Steam needs a few seconds until logout is complete, so the next login has to wait
+        this->loginLimiter.Drain();
+    }
+
+    this->InvalidateSession();
+}
+
+void WebAPI::CloseSession() {
+    // Unloading the extension waits for this, so don't wait as long as for other requests
+    if (this->requestTimeout <= 0 || this->requestTimeout > CLOSE_SESSION_TIMEOUT) {
+        this->requestTimeout = CLOSE_SESSION_TIMEOUT;
     }
 
-    // Accept all friends
-    Json::Value friendValue = friendListResult.get("friends", "");
+    this->Logout();
+}
+
+void WebAPI::InvalidateSession() {
+    // Steam already dropped an expired session, so there is nothing to logout and no need to wait for the next login
+    this->session.loggedIn = false;
+    this->session.accessToken = std::string();
+    this->session.steamId = std::string();
+    this->session.sessionId = std::string();
+    this->session.umqid = std::string();
 
-    for (int i = 0; friendValue.isValidIndex(i); i++) {
-        std::string steam = friendValue[i].get("steamid", "").asString();
-        std::string relation = friendValue[i].get("relationship", "").asString();
+    this->sessionExpired = false;
+}
 
-        if (relation == "requestrecipient") {
-            // Accept the friend if there is a request
-            this->AcceptFriend(sessionid, steamid, steam);
+WebAPIResult_t WebAPI::DeliverMessage(Config &config, std::vector<std::string> &texts, std::vector<uint64_t> &recipients, std::vector<std::unordered_set<uint64_t>> &delivered,
+                                      std::vector<WebAPIResult_t> &textResults) {
+    WebAPIResult_t result;
 
-            // Add a second timeout, as otherwise two consecutive requests can fail!
-            sleep_ms(1000);
+    // Only login if there is no valid session yet
+    if (!this->session.loggedIn) {
+        result = this->Login(config);
+        if (result.type != WebAPIResult_SUCCESS) {
+            return result;
         }
+    } else {
+        Debug("[DEBUG] Reusing existing session");
     }
 
-    // Get user stats
-    Json::Value userStatsResult = this->GetUserStats(accessToken, recipientsCopy);
-    if (!userStatsResult["success"].asBool()) {
-        LogError(userStatsResult["error"].asString().c_str());
+    result.loginTime = std::chrono::steady_clock::now();
 
-        result.type = WebAPIResult_API_ERROR;
-        result.error = loginSteamCommunityResult["error"].asString();
-        return result;
+    // Only get user stats of recipients without a valid cached presence
+    std::vector<uint64_t> unknownRecipients = this->GetUncachedRecipients(recipients, config.presenceCacheTime);
+
+    std::vector<PlayerSummary_t> players;
+    if (!unknownRecipients.empty()) {
+        // Get user stats
+        Json::Value userStatsResult = this->GetUserStats(this->session.accessToken, unknownRecipients, players);
+        if (!userStatsResult["success"].asBool()) {
+            LogError(userStatsResult["error"].asString().c_str());
+
+            result.type = WebAPIResult_API_ERROR;
+            result.error = userStatsResult["error"].asString();
+            return result;
+        }
+    }
+
+    // Collect all valid recipients which are online
+    std::vector<uint64_t> onlineRecipients;
+    if (config.presenceCacheTime > 0) {
+        this->UpdatePresenceCache(players, unknownRecipients);
+        onlineRecipients = this->GetCachedOnlineRecipients(recipients);
+    } else {
+        onlineRecipients = WebAPI::GetOnlineRecipients(players, recipients);
     }
 
-    // Check if there is valid recipient which is online
-    Json::Value userValues = userStatsResult.get("players", "");
-    for (auto recipient = recipientsCopy.begin(); recipient != recipientsCopy.end(); recipient++) {
-        for (int i = 0; userValues.isValidIndex(i); i++) {
-            std::string steam = userValues[i].get("steamid", "").asString();
-            int online = userValues[i].get("personastate", 0).asInt();
+    if (config.parallelSend) {
+        // Send every message to all recipients at once
+        for (size_t i = 0; i < texts.size(); i++) {
+            std::vector<uint64_t> pendingRecipients;
+            for (auto recipient = onlineRecipients.begin(); recipient != onlineRecipients.end(); recipient++) {
+                if (delivered[i].count(*recipient) == 0) {
+                    pendingRecipients.push_back(*recipient);
+                }
+            }
+
+            if (pendingRecipients.empty()) {
+                continue;
+            }
+
+            // Limit once per message for the whole account instead of once per recipient
+            this->messageLimiter.Acquire();
 
-            if (steam == std::to_string(*recipient) && online) {
-                // Send the message to the recipient
-                Json::Value sendMessageResult = this->SendSteamMessage(accessToken, umqid, *recipient, message.text);
+            std::vector<Json::Value> sendMessageResults = this->SendSteamMessageParallel(this->session.accessToken, this->session.umqid, pendingRecipients, texts[i]);
+
+            // Remember every recipient who got the text before reporting an error, so a retry doesn't send it twice
+            Json::Value failedResult;
+            for (size_t j = 0; j < sendMessageResults.size(); j++) {
+                if (sendMessageResults[j]["success"].asBool()) {
+                    delivered[i].insert(pendingRecipients[j]);
+                    WebAPI::MarkDelivered(result);
+                    WebAPI::MarkDelivered(textResults[i]);
+                } else if (failedResult.isNull()) {
+                    failedResult = sendMessageResults[j];
+                }
+            }
+
+            if (!failedResult.isNull()) {
+                LogError(failedResult["error"].asString().c_str());
+                WebAPI::MarkCompleteTexts(onlineRecipients, delivered, textResults);
+
+                result.type = WebAPIResult_API_ERROR;
+                result.error = failedResult["error"].asString();
+                return result;
+            }
+        }
+    } else {
+        for (auto recipient = onlineRecipients.begin(); recipient != onlineRecipients.end(); recipient++) {
+            // Send the messages to the recipient
+            for (size_t i = 0; i < texts.size(); i++) {
+                // Already got it before the session expired
+                if (delivered[i].count(*recipient) != 0) {
+                    continue;
+                }
+
+                // Limit the messages, as the user may occur some limitations on how much messages he can send
+                this->messageLimiter.Acquire();
+
+                Json::Value sendMessageResult = this->SendSteamMessage(this->session.accessToken, this->session.umqid, *recipient, texts[i]);
                 if (!sendMessageResult["success"].asBool()) {
                     LogError(sendMessageResult["error"].asString().c_str());
-                    this->LogoutWebAPI();
-
-                    // Wait after logout, as steam needs a few seconds until logout is complete
-                    sleep_ms(message.config.waitAfterLogout);
+                    WebAPI::MarkCompleteTexts(onlineRecipients, delivered, textResults);
 
                     result.type = WebAPIResult_API_ERROR;
-                    result.error = loginSteamCommunityResult["error"].asString();
+                    result.error = sendMessageResult["error"].asString();
                     return result;
                 }
 
-                // Wait between messages, as the user may occur some limitations on how much messages he can send
-                sleep_ms(message.config.waitBetweenMessages);
-                break;
+                delivered[i].insert(*recipient);
+                WebAPI::MarkDelivered(result);
+                WebAPI::MarkDelivered(textResults[i]);
             }
         }
     }
 
-    // Logout on finish
-    this->LogoutWebAPI();
+    Debug("[DEBUG] Sent message");
+    WebAPI::MarkCompleteTexts(onlineRecipients, delivered, textResults);
 
-    // Wait after logout, as steam needs a few seconds until logout is complete
-    sleep_ms(message.config.waitAfterLogout);
+    result.type = WebAPIResult_SUCCESS;
+    result.error = std::string();
+    return result;
+}
 
-    Debug("[DEBUG] Sent message");
+WebAPIResult_t WebAPI::UpdateFriends(Config &config, std::function<bool()> &isInterrupted) {
+    WebAPIResult_t result;
+
+    // Only login if there is no valid session yet
+    if (!this->session.loggedIn) {
+        result = this->Login(config);
+        if (result.type != WebAPIResult_SUCCESS) {
+            return result;
+        }
+    }
+
+    // Get friend list
+    std::vector<uint64_t> friendList;
+    std::vector<uint64_t> friendRequests;
+
+    Json::Value friendListResult = this->GetFriendList(this->session.accessToken, friendList, friendRequests);
+    if (!friendListResult["success"].asBool()) {
+        LogError(friendListResult["error"].asString().c_str());
+
+        result.type = WebAPIResult_API_ERROR;
+        result.error = friendListResult["error"].asString();
+        return result;
+    }
+
+    // Compare the friend list with the last known state
+    std::unordered_set<uint64_t> friends(friendList.begin(), friendList.end());
+    std::vector<uint64_t> newRequests;
+
+    for (auto steamId = friendRequests.begin(); steamId != friendRequests.end(); steamId++) {
+        if (this->friends.count(*steamId)) {
+            // Already accepted, but not yet updated by steam
+            friends.insert(*steamId);
+        } else {
+            newRequests.push_back(*steamId);
+        }
+    }
+
+    this->friends.swap(friends);
+
+    // Accept all new friends
+    for (auto steam = newRequests.begin(); steam != newRequests.end(); steam++) {
+        // Leave the remaining requests to the next check, as messages are more important
+        if (isInterrupted && isInterrupted()) {
+            Debug("[DEBUG] Accepting friends interrupted by a new message");
+            break;
+        }
+
+        // Limit the requests, as otherwise two consecutive requests can fail!
+        this->communityLimiter.Acquire();
+
+        Json::Value acceptFriendResult = this->AcceptFriend(this->session.sessionId, this->session.steamId, std::to_string(*steam));
+        if (!acceptFriendResult["success"].asBool()) {
+            LogError(acceptFriendResult["error"].asString().c_str());
+            continue;
+        }
+
+        this->friends.insert(*steam);
+    }
 
     result.type = WebAPIResult_SUCCESS;
     result.error = std::string();
     return result;
 }
 
-WebAPI::WriteDataInfo WebAPI::GetPage(CURL *client, std::string url, std::string useragent, char *post, ...) {
+void WebAPI::MarkCompleteTexts(std::vector<uint64_t> &onlineRecipients, std::vector<std::unordered_set<uint64_t>> &delivered, std::vector<WebAPIResult_t> &textResults) {
+    // A text is complete as soon as every online recipient got it, even if the delivery of another text failed
+    for (size_t i = 0; i < textResults.size(); i++) {
+        bool isComplete = true;
+
+        for (auto recipient = onlineRecipients.begin(); recipient != onlineRecipients.end(); recipient++) {
+            if (delivered[i].count(*recipient) == 0) {
+                isComplete = false;
+                break;
+            }
+        }
+
+        if (isComplete) {
+            textResults[i].type = WebAPIResult_SUCCESS;
+            textResults[i].error = std::string();
+        }
+    }
+}
+
+void WebAPI::MarkDelivered(WebAPIResult_t &result) {
+    // Remember when the first and the last recipient got a message
+    result.lastDeliveryTime = std::chrono::steady_clock::now();
+
+    if (result.firstDeliveryTime == std::chrono::steady_clock::time_point()) {
+        result.firstDeliveryTime = result.lastDeliveryTime;
+    }
+}
+
+WebAPI::WriteDataInfo &WebAPI::GetPage(CURL *client, std::string step, std::string url, std::string useragent, const FormBody *postData) {
+    PageRequest request;
+    request.step = step;
+    request.url = url;
+    request.postData = postData;
+
+    // Prepare the curl handle, the response buffer of the handle is reused
+    WriteDataInfo &writeData = this->responses[client];
+    struct curl_slist *chunk = this->PrepareRequest(client, request, useragent, &writeData);
+
+    // Perform curl request
+    CURLcode curlCode = curl_easy_perform(client);
+    this->FinishRequest(client, request, curlCode, &writeData, chunk);
+
+    // Return result
+    return writeData;
+}
+
+void WebAPI::GetPages(std::vector<PageRequest> &requests, std::string useragent) {
+    // The response buffers are only added, never removed, so they are reused by the next calls
+    if (this->pageResponses.size() < requests.size()) {
+        this->pageResponses.resize(requests.size());
+    }
+
+    std::vector<struct curl_slist *> chunks(requests.size(), nullptr);
+
+    // Create enough handles for the parallel requests, they are reused for the next time
+    size_t parallelRequests = (std::min)(requests.size(), static_cast<size_t>(MAX_PARALLEL_REQUESTS));
+    while (this->parallelClients.size() < parallelRequests) {
+        this->parallelClients.push_back(curl_easy_init());
+    }
+
+    std::vector<CURL *> freeClients(this->parallelClients.begin(), this->parallelClients.begin() + parallelRequests);
+    size_t activeRequests = 0;
+    size_t nextRequest = 0;
+
+    while (nextRequest < requests.size() || activeRequests > 0) {
+        // Start new requests as long as there are free handles
+        while (nextRequest < requests.size() && !freeClients.empty()) {
+            CURL *client = freeClients.back();
+            freeClients.pop_back();
+
+            chunks[nextRequest] = this->PrepareRequest(client, requests[nextRequest], useragent, &this->pageResponses[nextRequest]);
+
+            // The handle remembers the index of its request
+            curl_easy_setopt(client, CURLOPT_PRIVATE, reinterpret_cast<char *>(nextRequest));
+            curl_multi_add_handle(this->multiClient, client);
+
+            activeRequests++;
+            nextRequest++;
+        }
+
+        int runningRequests = 0;
+        curl_multi_perform(this->multiClient, &runningRequests);
+
+        // Check for finished requests
+        int messagesLeft = 0;
+        CURLMsg *message;
+        while ((message = curl_multi_info_read(this->multiClient, &messagesLeft))) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            CURL *client = message->easy_handle;
+            CURLcode curlCode = message->data.result;
+
+            char *privateData = nullptr;
+            curl_easy_getinfo(client, CURLINFO_PRIVATE, &privateData);
+            size_t index = reinterpret_cast<size_t>(privateData);
+
+            this->FinishRequest(client, requests[index], curlCode, &this->pageResponses[index], chunks[index]);
+            curl_multi_remove_handle(this->multiClient, client);
+
+            activeRequests--;
+            freeClients.push_back(client);
+        }
+
+        // Wait for activity on the running requests
+        if (activeRequests > 0) {
+            curl_multi_wait(this->multiClient, nullptr, 0, 1000, nullptr);
+        }
+    }
+}
+
+struct curl_slist *WebAPI::PrepareRequest(CURL *client, PageRequest &request, std::string &useragent, WriteDataInfo *writeData) {
     // First reset the curl handle
     curl_easy_reset(client);
 
-    // Process post list
-    char postStr[1024];
-    if (post) {
-        va_list argptr;
-
-        va_start(argptr, post);
-        vsprintf(postStr, post, argptr);
-        va_end(argptr);
-    } else {
-        postStr[0] = '\0';
+    // Reuse DNS entries, TLS sessions and connections of previous requests
+    if (this->shareClient) {
+        curl_easy_setopt(client, CURLOPT_SHARE, this->shareClient);
     }
 
     // Set URL
-    curl_easy_setopt(client, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(client, CURLOPT_URL, request.url.c_str());
 
     // Disable SSL verifying for peer
     curl_easy_setopt(client, CURLOPT_SSL_VERIFYPEER, 0L);
 
-#if defined unix || defined __unix__ || defined __linux__ || defined __unix || defined __APPLE__ || defined __darwin__
+#if defined SOURCEMOD_BUILD && (defined unix || defined __unix__ || defined __linux__ || defined __unix || defined __APPLE__ || defined __darwin__)
     // Use our own ca-bundle on unix like systems
     char caPath[PLATFORM_MAX_PATH + 1];
     smutils->BuildPath(Path_SM, caPath, sizeof(caPath), "data/messagebot/ca-bundle.crt");
@@ -574,10 +1153,22 @@ WebAPI::WriteDataInfo WebAPI::GetPage(CURL *client, std::string url, std::string
     }
 #endif
 
+    // Reuse the buffer of the last response, unless it got too large to keep it
+    if (writeData->content.capacity() > MAX_KEPT_RESPONSE_SIZE) {
+        std::string().swap(writeData->content);
+    }
+
+    writeData->content.clear();
+    writeData->error.clear();
+    writeData->responseCode = 0;
+
     // Set the write function and data
-    WriteDataInfo writeData;
     curl_easy_setopt(client, CURLOPT_WRITEFUNCTION, WebAPI::WriteData);
-    curl_easy_setopt(client, CURLOPT_WRITEDATA, &writeData);
+    curl_easy_setopt(client, CURLOPT_WRITEDATA, writeData);
+
+    // The headers tell the content length, so the buffer can be reserved at once
+    curl_easy_setopt(client, CURLOPT_HEADERFUNCTION, WebAPI::WriteHeader);
+    curl_easy_setopt(client, CURLOPT_HEADERDATA, writeData);
 
     // Set timeout
     curl_easy_setopt(client, CURLOPT_TIMEOUT, this->requestTimeout);
@@ -586,8 +1177,8 @@ WebAPI::WriteDataInfo WebAPI::GetPage(CURL *client, std::string url, std::string
     curl_easy_setopt(client, CURLOPT_NOSIGNAL, 1L);
 
     // Collect error information
-    char errorBuffer[CURL_ERROR_SIZE + 1];
-    curl_easy_setopt(client, CURLOPT_ERRORBUFFER, errorBuffer);
+    writeData->errorBuffer[0] = '\0';
+    curl_easy_setopt(client, CURLOPT_ERRORBUFFER, writeData->errorBuffer);
 
     // Set the http user agent
     curl_easy_setopt(client, CURLOPT_USERAGENT, useragent.c_str());
@@ -595,13 +1186,13 @@ WebAPI::WriteDataInfo WebAPI::GetPage(CURL *client, std::string url, std::string
     // Disable following redirects
     curl_easy_setopt(client, CURLOPT_FOLLOWLOCATION, 0L);
 
-    // Append post data
+    // Append post data, curl sends the Content-Length of the given size
     struct curl_slist *chunk = nullptr;
-    if (strlen(postStr) > 0) {
+    if (request.postData && !request.postData->IsEmpty()) {
         chunk = curl_slist_append(chunk, "Content-Type: application/x-www-form-urlencoded");
-        chunk = curl_slist_append(chunk, (std::string("Content-length: ") + std::to_string(strlen(postStr))).c_str());
 
-        curl_easy_setopt(client, CURLOPT_POSTFIELDS, postStr);
+        curl_easy_setopt(client, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.postData->GetLength()));
+        curl_easy_setopt(client, CURLOPT_POSTFIELDS, request.postData->GetData());
     }
 
     // Enable cookie tracking
@@ -612,7 +1203,7 @@ WebAPI::WriteDataInfo WebAPI::GetPage(CURL *client, std::string url, std::string
         curl_easy_setopt(client, CURLOPT_HTTPHEADER, chunk);
     }
 
-    Debug("[DEBUG] Request to '%s' with data '%s'", url.c_str(), postStr);
+    Debug("[DEBUG] Request to '%s' with data '%s'", request.url.c_str(), request.postData ? request.postData->GetData() : "");
 
     if (this->debugEnabled) {
 #if !defined SOURCEMOD_BUILD
@@ -632,21 +1223,67 @@ WebAPI::WriteDataInfo WebAPI::GetPage(CURL *client, std::string url, std::string
         }
     }
 
-    // Perform curl request
-    if (curl_easy_perform(client) != CURLE_OK) {
-        writeData.content = errorBuffer;
-        writeData.error = errorBuffer;
+    return chunk;
+}
+
+void WebAPI::FinishRequest(CURL *client, PageRequest &request, CURLcode curlCode, WriteDataInfo *writeData, struct curl_slist *chunk) {
+    if (curlCode != CURLE_OK) {
+        writeData->content = writeData->errorBuffer;
+        writeData->error = writeData->errorBuffer;
+    } else {
+        curl_easy_getinfo(client, CURLINFO_RESPONSE_CODE, &writeData->responseCode);
     }
 
+    this->TraceRequest(client, request, curlCode, writeData);
+
     // Clean up curl
     if (chunk) {
         curl_slist_free_all(chunk);
     }
 
-    Debug("[DEBUG] Response from '%s' with content '%s'", url.c_str(), writeData.content.c_str());
+    Debug("[DEBUG] Response from '%s' with content '%s'", request.url.c_str(), writeData->content.c_str());
+}
 
-    // Return result
-    return writeData;
+void WebAPI::TraceRequest(CURL *client, PageRequest &request, CURLcode curlCode, WriteDataInfo *writeData) {
+    RequestTrace_t trace;
+    trace.step = request.step;
+    trace.responseCode = writeData->responseCode;
+    trace.success = curlCode == CURLE_OK;
+
+    // Curl reports the times in seconds since the start of the request
+    double dnsDone = 0, connectDone = 0, tlsDone = 0, firstByte = 0, total = 0;
+    curl_easy_getinfo(client, CURLINFO_NAMELOOKUP_TIME, &dnsDone);
+    curl_easy_getinfo(client, CURLINFO_CONNECT_TIME, &connectDone);
+    curl_easy_getinfo(client, CURLINFO_APPCONNECT_TIME, &tlsDone);
+    curl_easy_getinfo(client, CURLINFO_STARTTRANSFER_TIME, &firstByte);
+    curl_easy_getinfo(client, CURLINFO_TOTAL_TIME, &total);
+#if LIBCURL_VERSION_NUM >= 0x073700
+    curl_off_t bytesReceived = 0;
+    curl_easy_getinfo(client, CURLINFO_SIZE_DOWNLOAD_T, &bytesReceived);
+    trace.bytesReceived = static_cast<double>(bytesReceived);
+#else
+    curl_easy_getinfo(client, CURLINFO_SIZE_DOWNLOAD, &trace.bytesReceived);
+#endif
+
+    // A reused connection has no connect and handshake times
+    connectDone = (std::max)(connectDone, dnsDone);
+    tlsDone = (std::max)(tlsDone, connectDone);
+
+    trace.dnsTime = dnsDone * 1000;
+    trace.connectTime = (connectDone - dnsDone) * 1000;
+    trace.tlsTime = (tlsDone - connectDone) * 1000;
+    trace.firstByteTime = (std::max)(firstByte - tlsDone, 0.0) * 1000;
+    trace.totalTime = total * 1000;
+
+    this->requestTracer.Record(trace);
+}
+
+std::string WebAPI::GetRequestTraces(size_t maxLength) {
+    return this->requestTracer.ToJson(maxLength);
+}
+
+std::vector<std::string> WebAPI::GetRequestTraceRecords() {
+    return this->requestTracer.ToJsonRecords();
 }
 
 void WebAPI::AddCookie(CURL *client, std::string cookie) {
@@ -673,21 +1310,118 @@ std::string WebAPI::GetCookie(CURL *client, std::string cookieName) {
     return std::string();
 }
 
-std::string WebAPI::urlencode(std::string str) {
-    CURL *curl = curl_easy_init();
-    std::string ret = "";
+CURLSH *WebAPI::CreateShareClient() {
+    CURLSH *shareClient = curl_share_init();
+    if (!shareClient) {
+        return nullptr;
+    }
+
+    curl_share_setopt(shareClient, CURLSHOPT_LOCKFUNC, LockShare);
+    curl_share_setopt(shareClient, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+
+    // Share DNS lookups, TLS sessions and open connections
+    curl_share_setopt(shareClient, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(shareClient, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(shareClient, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
 
-    if (curl) {
-        char *escaped = curl_easy_escape(curl, str.c_str(), str.length());
-        if (escaped) {
-            ret = escaped;
-            curl_free(escaped);
+    return shareClient;
+}
+
+void WebAPI::DestroyShareClient(CURLSH *shareClient) {
+    if (shareClient) {
+        curl_share_cleanup(shareClient);
+    }
+}
+
+std::vector<uint64_t> WebAPI::GetOnlineRecipients(const std::vector<PlayerSummary_t> &players, const std::vector<uint64_t> &recipients) {
+    // Index all online players once
+    std::unordered_set<uint64_t> onlinePlayers;
+    for (auto player = players.begin(); player != players.end(); player++) {
+        if (player->personaState) {
+            onlinePlayers.insert(player->steamId);
+        }
+    }
+
+    // Keep the order of the recipients
+    std::vector<uint64_t> onlineRecipients;
+    for (auto recipient = recipients.begin(); recipient != recipients.end(); recipient++) {
+        if (onlinePlayers.count(*recipient)) {
+            onlineRecipients.push_back(*recipient);
         }
+    }
+
+    return onlineRecipients;
+}
+
+std::vector<uint64_t> WebAPI::GetUncachedRecipients(const std::vector<uint64_t> &recipients, int presenceCacheTime) {
+    if (presenceCacheTime <= 0) {
+        return recipients;
+    }
+
+    std::vector<uint64_t> uncachedRecipients;
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto recipient = recipients.begin(); recipient != recipients.end(); recipient++) {
+        auto presence = this->presenceCache.find(*recipient);
+
+        if (presence != this->presenceCache.end() && now - presence->second.updateTime < std::chrono::milliseconds(presenceCacheTime)) {
+            this->presenceCacheHits++;
+        } else {
+            this->presenceCacheMisses++;
+            uncachedRecipients.push_back(*recipient);
+        }
+    }
+
+    return uncachedRecipients;
+}
+
+void WebAPI::UpdatePresenceCache(const std::vector<PlayerSummary_t> &players, const std::vector<uint64_t> &recipients) {
+    auto now = std::chrono::steady_clock::now();
+
+    // Recipients not known by steam are cached as offline
+    for (auto recipient = recipients.begin(); recipient != recipients.end(); recipient++) {
+        Presence &presence = this->presenceCache[*recipient];
+        presence.personaState = 0;
+        presence.updateTime = now;
+    }
+
+    for (auto player = players.begin(); player != players.end(); player++) {
+        Presence &presence = this->presenceCache[player->steamId];
+        presence.personaState = player->personaState;
+        presence.updateTime = now;
+    }
+}
+
+std::vector<uint64_t> WebAPI::GetCachedOnlineRecipients(const std::vector<uint64_t> &recipients) {
+    std::vector<uint64_t> onlineRecipients;
+
+    for (auto recipient = recipients.begin(); recipient != recipients.end(); recipient++) {
+        auto presence = this->presenceCache.find(*recipient);
 
-        curl_easy_cleanup(curl);
+        if (presence != this->presenceCache.end() && presence->second.personaState) {
+            onlineRecipients.push_back(*recipient);
+        }
     }
 
-    return ret;
+    return onlineRecipients;
+}
+
+unsigned int WebAPI::GetPresenceCacheHits() {
+    return this->presenceCacheHits;
+}
+
+unsigned int WebAPI::GetPresenceCacheMisses() {
+    return this->presenceCacheMisses;
+}
+
+void WebAPI::CheckSessionExpired(WriteDataInfo &pageInfo, std::string error) {
+    // Steam answers with 401 on an invalid access token and with 'Not Logged On' on an invalid UMQID
+    if (pageInfo.responseCode == 401 || error == "Not Logged On") {
+        Debug("[DEBUG] Session is not valid anymore");
+        this->sessionExpired = true;
+    }
 }
 
 size_t WebAPI::WriteData(char *ptr, size_t size, size_t nmemb, void *userdata) {
@@ -700,3 +1434,19 @@ size_t WebAPI::WriteData(char *ptr, size_t size, size_t nmemb, void *userdata) {
 
     return realsize;
 }
+
+size_t WebAPI::WriteHeader(char *buffer, size_t size, size_t nitems, void *userdata) {
+    // Get the data info
+    WebAPI::WriteDataInfo *dataInfo = static_cast<WebAPI::WriteDataInfo *>(userdata);
+
+    // Reserve the content at once, a header line always ends with a line break
+    static const char contentLength[] = "Content-Length:";
+    size_t realsize = size * nitems;
+
+    if (realsize > sizeof(contentLength) - 1 && curl_strnequal(buffer, contentLength, sizeof(contentLength) - 1)) {
+        size_t length = static_cast<size_t>(strtoull(buffer + sizeof(contentLength) - 1, nullptr, 10));
+        dataInfo->content.reserve((std::min)(length, static_cast<size_t>(MAX_KEPT_RESPONSE_SIZE)));
+    }
+
+    return realsize;
+}
@@ -28,50 +28,196 @@
 #define _WEB_API_H_
 
 #include "3rdparty/json/json/json.h"
+#include "FormBody.h"
+#include "JsonCursor.h"
 #include "Message.h"
+#include "RateLimiter.h"
+#include "RequestTracer.h"
 #include "WebAPIResult.h"
+#include "rsa/RSAKey.h"
 
 #include <curl/curl.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <vector>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Online state of a player from a user summary
+typedef struct {
+    uint64_t steamId;
+    int personaState;
+} PlayerSummary_t;
 
 class WebAPI {
 private:
+    typedef struct {
+        bool loggedIn;
+        std::string username;
+        std::string password;
+        std::string accessToken;
+        std::string steamId;
+        std::string sessionId;
+        std::string umqid;
+    } Session;
+
+    // Response of a request, kept and reused for the next requests
+    typedef struct {
+        std::string content;
+        std::string error;
+        long responseCode;
+        char errorBuffer[CURL_ERROR_SIZE + 1];
+    } WriteDataInfo;
+
+    typedef struct {
+        std::string step;
+        std::string url;
+        const FormBody *postData;
+    } PageRequest;
+
+    typedef struct {
+        int personaState;
+        std::chrono::steady_clock::time_point updateTime;
+    } Presence;
+
+    typedef struct {
+        std::string timestamp;
+        std::string mod;
+        std::string exp;
+        std::shared_ptr<RSAKey> key;
+        std::string password;
+        std::string encryptedPassword;
+    } CachedRSAKey;
+
     bool debugEnabled;
     int requestTimeout;
 
+    std::string steamCommunityUrl;
+    std::string webApiUrl;
+
     CURL *webAPIClient;
     CURL *steamCommunityClient;
 
+    // Used for requests running at the same time
+    CURLM *multiClient;
+
+    // Not owned, shared with other web APIs
+    CURLSH *shareClient;
+    std::vector<CURL *> parallelClients;
+
+    // Response buffers of the single requests per handle and of the parallel requests per request
+    std::unordered_map<CURL *, WriteDataInfo> responses;
+    std::vector<WriteDataInfo> pageResponses;
+
+    // Bodies of the single and of the parallel POST requests, kept for the next requests
+    FormBody form;
+    std::vector<FormBody> parallelForms;
+
+    // The session is kept between messages and only renewed if steam rejects it
+    Session session;
+    bool sessionExpired;
+
+    // Limits for the different kind of requests
+    RateLimiter loginLimiter;
+    RateLimiter communityLimiter;
+    RateLimiter messageLimiter;
+
+    // Last known presence of recipients, the counters are read by other threads
+    std::unordered_map<uint64_t, Presence> presenceCache;
+    std::atomic<unsigned int> presenceCacheHits;
+    std::atomic<unsigned int> presenceCacheMisses;
+
+    // Timings of the last requests
+    RequestTracer requestTracer;
+
+    // Last known friends of the logged in account
+    std::unordered_set<uint64_t> friends;
+
+    // RSA key of the last login, steam returns the same key with the same timestamp for a while
+    CachedRSAKey rsaKey;
+
 public:
-    WebAPI();
+    WebAPI(CURLSH *shareClient = nullptr);
     ~WebAPI();
 
+    // Share handle for DNS lookups, TLS sessions and connections, has to outlive all web APIs using it
+    static CURLSH *CreateShareClient();
+    static void DestroyShareClient(CURLSH *shareClient);
+
     WebAPIResult_t SendSteamMessage(Message message);
 
+    // Returns the result of every text at the same index
+    std::vector<WebAPIResult_t> SendSteamMessages(Config config, std::vector<std::string> texts);
+
+    // Accepts new friend requests, stops early as soon as isInterrupted returns true
+    WebAPIResult_t AcceptFriendRequests(Config config, std::function<bool()> isInterrupted);
+
+    // Logs out of the kept session with a short timeout, the next message logs in again
+    void CloseSession();
+
+    // Returns all recipients which are online according to the players of a user summary
+    static std::vector<uint64_t> GetOnlineRecipients(const std::vector<PlayerSummary_t> &players, const std::vector<uint64_t> &recipients);
+
+    // Returns the timings of the last requests as JSON array with at most maxLength characters, can be called by any thread
+    std::string GetRequestTraces(size_t maxLength = std::string::npos);
+
+    // Returns the timings of the last requests as one JSON object per request from new to old, can be called by any thread
+    std::vector<std::string> GetRequestTraceRecords();
+
+    unsigned int GetPresenceCacheHits();
+    unsigned int GetPresenceCacheMisses();
+
 private:
-    typedef struct {
-        std::string content;
-        std::string error;
-    } WriteDataInfo;
+    void ApplyConfig(Config &config);
+    void CheckSession(Config &config);
+
+    WebAPIResult_t Login(Config &config);
+    void Logout();
+    void InvalidateSession();
+
+    // Skips and adds the recipients in delivered, which has one set of recipients per text, and marks every completed text in textResults
+    WebAPIResult_t DeliverMessage(Config &config, std::vector<std::string> &texts, std::vector<uint64_t> &recipients, std::vector<std::unordered_set<uint64_t>> &delivered,
+                                  std::vector<WebAPIResult_t> &textResults);
+    WebAPIResult_t UpdateFriends(Config &config, std::function<bool()> &isInterrupted);
+    static void MarkCompleteTexts(std::vector<uint64_t> &onlineRecipients, std::vector<std::unordered_set<uint64_t>> &delivered, std::vector<WebAPIResult_t> &textResults);
+    static void MarkDelivered(WebAPIResult_t &result);
 
     Json::Value LoginSteamCommunity(std::string username, std::string password);
     Json::Value LoginWebAPI(std::string accessToken);
     void LogoutWebAPI();
 
-    Json::Value GetFriendList(std::string accessToken);
-    Json::Value GetUserStats(std::string accessToken, std::vector<uint64_t> &users);
+    Json::Value GetFriendList(std::string accessToken, std::vector<uint64_t> &friends, std::vector<uint64_t> &friendRequests);
+    Json::Value GetUserStats(std::string accessToken, std::vector<uint64_t> &users, std::vector<PlayerSummary_t> &players);
     Json::Value AcceptFriend(std::string sessionId, std::string ownSteamId, std::string friendSteamId);
     Json::Value SendSteamMessage(std::string accessToken, std::string umqid, uint64_t steamid, std::string text);
+    std::vector<Json::Value> SendSteamMessageParallel(std::string accessToken, std::string umqid, std::vector<uint64_t> &steamids, std::string text);
+    Json::Value ParseSendMessageResult(WriteDataInfo &pageInfo);
+
+    // The response is valid until the next request with the same client
+    WebAPI::WriteDataInfo &GetPage(CURL *client, std::string step, std::string url, std::string userAgent, const FormBody *postData);
+
+    // The responses are in pageResponses at the index of their request, valid until the next call
+    void GetPages(std::vector<PageRequest> &requests, std::string useragent);
 
-    WebAPI::WriteDataInfo GetPage(CURL *client, std::string url, std::string userAgent, char *post, ...);
-    std::string urlencode(std::string str);
+    struct curl_slist *PrepareRequest(CURL *client, PageRequest &request, std::string &useragent, WriteDataInfo *writeData);
+    void FinishRequest(CURL *client, PageRequest &request, CURLcode curlCode, WriteDataInfo *writeData, struct curl_slist *chunk);
+    void TraceRequest(CURL *client, PageRequest &request, CURLcode curlCode, WriteDataInfo *writeData);
 
     void AddCookie(CURL *client, std::string cookie);
     std::string GetCookie(CURL *client, std::string cookieName);
 
+    std::vector<uint64_t> GetUncachedRecipients(const std::vector<uint64_t> &recipients, int presenceCacheTime);
+    void UpdatePresenceCache(const std::vector<PlayerSummary_t> &players, const std::vector<uint64_t> &recipients);
+    std::vector<uint64_t> GetCachedOnlineRecipients(const std::vector<uint64_t> &recipients);
+
+    void CheckSessionExpired(WriteDataInfo &pageInfo, std::string error);
+
     static size_t WriteData(char *ptr, size_t size, size_t nmemb, void *userdata);
+    static size_t WriteHeader(char *buffer, size_t size, size_t nitems, void *userdata);
 };
 
 #endif
\ No newline at end of file
@@ -27,6 +27,7 @@
 #ifndef _WEB_API_RESULT_H_
 #define _WEB_API_RESULT_H_
 
+#include <chrono>
 #include <string>
 
 enum WebAPIResult_Type {
@@ -34,11 +35,17 @@ enum WebAPIResult_Type {
     WebAPIResult_NO_RECEIVER,
     WebAPIResult_LOGIN_ERROR,
     WebAPIResult_API_ERROR,
+    WebAPIResult_QUEUE_FULL,
 };
 
 typedef struct {
     WebAPIResult_Type type;
     std::string error;
+
+    // Points in time of the delivery, not set if they weren't reached
+    std::chrono::steady_clock::time_point loginTime;
+    std::chrono::steady_clock::time_point firstDeliveryTime;
+    std::chrono::steady_clock::time_point lastDeliveryTime;
 } WebAPIResult_t;
 
 #endif
@@ -28,21 +28,11 @@
 #include "Config.h"
 #include "Message.h"
 #include "MessageBot.h"
-#include "MessageThread.h"
+#include "WebAPI.h"
 
 #include <sstream>
 #include <vector>
 
-enum MessageBot_Option {
-    OPTION_DEBUG,
-    OPTION_WAIT_BETWEEN_MESSAGES,
-    OPTION_WAIT_AFTER_LOGOUT,
-    OPTION_REQUEST_TIMEOUT,
-    OPTION_SHUFFLE_RECIPIENTS,
-    OPTION_MAX
-};
-
-
 cell_t MessageBot_SetLoginData(IPluginContext *pContext, const cell_t *params) {
     char *username;
     char *password;
@@ -75,16 +65,8 @@ cell_t MessageBot_SendBotMessage(IPluginContext *pContext, const cell_t *params)
     message.config = messageBotConfig;
     message.text = messageText;
 
-    // Start a new thread
-    MessageThread *messageThread = new MessageThread(message, callback);
-    if (!messageBot.RegisterAndStartThread(messageThread)) {
-        delete messageThread;
-
-        pContext->ThrowNativeError("Couldn't create a new thread");
-        return 0;
-    }
-
-    return 1;
+    // Queue the message for the message thread
+    return messageBot.QueueMessage(message, callback);
 }
 
 cell_t MessageBot_AddRecipient(IPluginContext *pContext, const cell_t *params) {
@@ -185,6 +167,39 @@ cell_t MessageBot_SetOption(IPluginContext *pContext, const cell_t *params) {
         case OPTION_SHUFFLE_RECIPIENTS:
             messageBotConfig.shuffleRecipients = params[2];
             break;
+        case OPTION_MAX_QUEUED_MESSAGES:
+            messageBotConfig.maxQueuedMessages = params[2];
+            break;
+        case OPTION_QUEUE_DROP_POLICY:
+            messageBotConfig.queueDropPolicy = params[2];
+            break;
+        case OPTION_BATCH_WINDOW:
+            messageBotConfig.batchWindow = params[2];
+            break;
+        case OPTION_PARALLEL_SEND:
+            messageBotConfig.parallelSend = params[2];
+            break;
+        case OPTION_WAIT_BETWEEN_COMMUNITY_REQUESTS:
+            messageBotConfig.waitBetweenCommunityRequests = params[2];
+            break;
+        case OPTION_MESSAGE_BURST:
+            messageBotConfig.messageBurst = params[2];
+            break;
+        case OPTION_LOGIN_BURST:
+            messageBotConfig.loginBurst = params[2];
+            break;
+        case OPTION_COMMUNITY_BURST:
+            messageBotConfig.communityBurst = params[2];
+            break;
+        case OPTION_PRESENCE_CACHE_TIME:
+            messageBotConfig.presenceCacheTime = params[2];
+            break;
+        case OPTION_FRIEND_CHECK_INTERVAL:
+            messageBotConfig.friendCheckInterval = params[2];
+            break;
+        case OPTION_CALLBACK_BUDGET:
+            messageBotConfig.callbackBudget = params[2];
+            break;
     }
 
     return 1;
@@ -209,11 +224,139 @@ cell_t MessageBot_GetOption(IPluginContext *pContext, const cell_t *params) {
             return messageBotConfig.requestTimeout;
         case OPTION_SHUFFLE_RECIPIENTS:
             return messageBotConfig.shuffleRecipients;
+        case OPTION_MAX_QUEUED_MESSAGES:
+            return messageBotConfig.maxQueuedMessages;
+        case OPTION_QUEUE_DROP_POLICY:
+            return messageBotConfig.queueDropPolicy;
+        case OPTION_BATCH_WINDOW:
+            return messageBotConfig.batchWindow;
+        case OPTION_PARALLEL_SEND:
+            return messageBotConfig.parallelSend;
+        case OPTION_WAIT_BETWEEN_COMMUNITY_REQUESTS:
+            return messageBotConfig.waitBetweenCommunityRequests;
+        case OPTION_MESSAGE_BURST:
+            return messageBotConfig.messageBurst;
+        case OPTION_LOGIN_BURST:
+            return messageBotConfig.loginBurst;
+        case OPTION_COMMUNITY_BURST:
+            return messageBotConfig.communityBurst;
+        case OPTION_PRESENCE_CACHE_TIME:
+            return messageBotConfig.presenceCacheTime;
+        case OPTION_FRIEND_CHECK_INTERVAL:
+            return messageBotConfig.friendCheckInterval;
+        case OPTION_CALLBACK_BUDGET:
+            return messageBotConfig.callbackBudget;
     }
 
     return 1;
 }
 
+cell_t MessageBot_GetQueueSize(IPluginContext *pContext, const cell_t *params) {
+    return static_cast<cell_t>(messageBot.GetQueueSize());
+}
+
+cell_t MessageBot_GetPresenceCacheStats(IPluginContext *pContext, const cell_t *params) {
+    cell_t *hits;
+    cell_t *misses;
+
+    pContext->LocalToPhysAddr(params[1], &hits);
+    pContext->LocalToPhysAddr(params[2], &misses);
+
+    *hits = static_cast<cell_t>(messageBot.GetWebAPI()->GetPresenceCacheHits());
+    *misses = static_cast<cell_t>(messageBot.GetWebAPI()->GetPresenceCacheMisses());
+
+    return 1;
+}
+
+cell_t MessageBot_GetStats(IPluginContext *pContext, const cell_t *params) {
+    cell_t *stats;
+    pContext->LocalToPhysAddr(params[1], &stats);
+
+    Stats &messageBotStats = messageBot.GetStats();
+
+    int size = params[2] < STAT_MAX ? params[2] : STAT_MAX;
+    for (int stat = 0; stat < size; stat++) {
+        unsigned int value = 0;
+
+        switch (stat) {
+            case STAT_FRAME_HOOK_CALLS:
+                value = messageBotStats.frameHookCalls.load();
+                break;
+            case STAT_FRAME_HOOK_BUSY_CALLS:
+                value = messageBotStats.frameHookBusyCalls.load();
+                break;
+            case STAT_FRAME_HOOK_TIME_P50:
+                value = messageBotStats.frameHookTime.GetPercentile(50);
+                break;
+            case STAT_FRAME_HOOK_TIME_P99:
+                value = messageBotStats.frameHookTime.GetPercentile(99);
+                break;
+            case STAT_FRAME_HOOK_TIME_MAX:
+                value = messageBotStats.frameHookTime.GetMax();
+                break;
+            case STAT_CALLBACKS_FIRED:
+                value = messageBotStats.callbacksFired.load();
+                break;
+            case STAT_CALLBACK_QUEUE_SIZE:
+                value = messageBotStats.GetCallbackQueueSize();
+                break;
+            case STAT_MESSAGE_QUEUE_SIZE:
+                value = static_cast<unsigned int>(messageBot.GetQueueSize());
+                break;
+            case STAT_QUEUE_WAIT_TIME_P50:
+                value = messageBotStats.latencies[LatencyPhase_TAKEN].GetPercentile(50);
+                break;
+            case STAT_QUEUE_WAIT_TIME_P99:
+                value = messageBotStats.latencies[LatencyPhase_TAKEN].GetPercentile(99);
+                break;
+            case STAT_QUEUE_WAIT_TIME_MAX:
+                value = messageBotStats.latencies[LatencyPhase_TAKEN].GetMax();
+                break;
+        }
+
+        stats[stat] = static_cast<cell_t>(value);
+    }
+
+    return size > 0 ? size : 0;
+}
+
+cell_t MessageBot_GetLatency(IPluginContext *pContext, const cell_t *params) {
+    if (params[1] < 0 || params[1] >= LatencyPhase_MAX) {
+        pContext->ThrowNativeError("Invalid latency phase %d", params[1]);
+        return 0;
+    }
+
+    Histogram &latency = messageBot.GetStats().latencies[params[1]];
+
+    cell_t *p50;
+    cell_t *p95;
+    cell_t *p99;
+
+    pContext->LocalToPhysAddr(params[2], &p50);
+    pContext->LocalToPhysAddr(params[3], &p95);
+    pContext->LocalToPhysAddr(params[4], &p99);
+
+    *p50 = static_cast<cell_t>(latency.GetPercentile(50));
+    *p95 = static_cast<cell_t>(latency.GetPercentile(95));
+    *p99 = static_cast<cell_t>(latency.GetPercentile(99));
+
+    return static_cast<cell_t>(latency.GetCount());
+}
+
+cell_t MessageBot_GetRequestTraces(IPluginContext *pContext, const cell_t *params) {
+    if (params[2] <= 0) {
+        return 0;
+    }
+
+    // Only serialize the newest requests which fit into the buffer, so the plugin always gets valid JSON
+    std::string traces = messageBot.GetWebAPI()->GetRequestTraces(static_cast<size_t>(params[2] - 1));
+
+    size_t written = 0;
+    pContext->StringToLocalUTF8(params[1], params[2], traces.c_str(), &written);
+
+    return static_cast<cell_t>(written);
+}
+
 uint64_t MessageBot_SteamId2toSteamId64(std::string steamId2) {
     // Maybe it's already a community Id
     if (steamId2.find(":") == std::string::npos) {
@@ -30,6 +30,41 @@
 #include "sdk/smsdk_ext.h"
 #include <string>
 
+enum MessageBot_Option {
+    OPTION_DEBUG,
+    OPTION_WAIT_BETWEEN_MESSAGES,
+    OPTION_WAIT_AFTER_LOGOUT,
+    OPTION_REQUEST_TIMEOUT,
+    OPTION_SHUFFLE_RECIPIENTS,
+    OPTION_MAX_QUEUED_MESSAGES,
+    OPTION_QUEUE_DROP_POLICY,
+    OPTION_BATCH_WINDOW,
+    OPTION_PARALLEL_SEND,
+    OPTION_WAIT_BETWEEN_COMMUNITY_REQUESTS,
+    OPTION_MESSAGE_BURST,
+    OPTION_LOGIN_BURST,
+    OPTION_COMMUNITY_BURST,
+    OPTION_PRESENCE_CACHE_TIME,
+    OPTION_FRIEND_CHECK_INTERVAL,
+    OPTION_CALLBACK_BUDGET,
+    OPTION_MAX
+};
+
+enum MessageBot_Stat {
+    STAT_FRAME_HOOK_CALLS,
+    STAT_FRAME_HOOK_BUSY_CALLS,
+    STAT_FRAME_HOOK_TIME_P50,
+    STAT_FRAME_HOOK_TIME_P99,
+    STAT_FRAME_HOOK_TIME_MAX,
+    STAT_CALLBACKS_FIRED,
+    STAT_CALLBACK_QUEUE_SIZE,
+    STAT_MESSAGE_QUEUE_SIZE,
+    STAT_QUEUE_WAIT_TIME_P50,
+    STAT_QUEUE_WAIT_TIME_P99,
+    STAT_QUEUE_WAIT_TIME_MAX,
+    STAT_MAX
+};
+
 cell_t MessageBot_SetLoginData(IPluginContext *pContext, const cell_t *params);
 cell_t MessageBot_SendBotMessage(IPluginContext *pContext, const cell_t *params);
 cell_t MessageBot_AddRecipient(IPluginContext *pContext, const cell_t *params);
@@ -38,6 +73,11 @@ cell_t MessageBot_IsRecipient(IPluginContext *pContext, const cell_t *params);
 cell_t MessageBot_ClearRecipients(IPluginContext *pContext, const cell_t *params);
 cell_t MessageBot_SetOption(IPluginContext *pContext, const cell_t *params);
 cell_t MessageBot_GetOption(IPluginContext *pContext, const cell_t *params);
+cell_t MessageBot_GetQueueSize(IPluginContext *pContext, const cell_t *params);
+cell_t MessageBot_GetPresenceCacheStats(IPluginContext *pContext, const cell_t *params);
+cell_t MessageBot_GetStats(IPluginContext *pContext, const cell_t *params);
+cell_t MessageBot_GetLatency(IPluginContext *pContext, const cell_t *params);
+cell_t MessageBot_GetRequestTraces(IPluginContext *pContext, const cell_t *params);
 
 uint64_t MessageBot_SteamId2toSteamId64(std::string steamId2);
 
@@ -51,6 +91,11 @@ static sp_nativeinfo_t messagebot_natives[] =
     { "MessageBot_ClearRecipients", MessageBot_ClearRecipients },
     { "MessageBot_SetOption", MessageBot_SetOption },
     { "MessageBot_GetOption", MessageBot_GetOption },
+    { "MessageBot_GetQueueSize", MessageBot_GetQueueSize },
+    { "MessageBot_GetPresenceCacheStats", MessageBot_GetPresenceCacheStats },
+    { "MessageBot_GetStats", MessageBot_GetStats },
+    { "MessageBot_GetLatency", MessageBot_GetLatency },
+    { "MessageBot_GetRequestTraces", MessageBot_GetRequestTraces },
     { NULL, NULL }
 };
 
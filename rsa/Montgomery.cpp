@@ -0,0 +1,281 @@
+/**
+ * -----------------------------------------------------
+ * File         Montgomery.cpp
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "Montgomery.h"
+
+#include <string.h>
+
+
+Montgomery::Montgomery() : inverse(0), limbs(0), length(0) {
+    memset(this->modulus, 0, sizeof(this->modulus));
+    memset(this->r2, 0, sizeof(this->r2));
+}
+
+bool Montgomery::SetModulus(const uint8_t *bytes, size_t length) {
+    // Skip leading zeros
+    while (length > 0 && *bytes == 0) {
+        bytes++;
+        length--;
+    }
+
+    if (length == 0 || length > MONTGOMERY_MAX_BITS / 8 || !(bytes[length - 1] & 1)) {
+        this->limbs = 0;
+        return false;
+    }
+
+    this->length = length;
+    this->limbs = (length + sizeof(MontgomeryLimb) - 1) / sizeof(MontgomeryLimb);
+    this->FromBytes(this->modulus, bytes, length);
+
+    if (this->limbs == 1 && this->modulus[0] == 1) {
+        this->limbs = 0;
+        return false;
+    }
+
+    // Newton iteration for the inverse of the lowest limb, every step doubles the correct bits
+    MontgomeryLimb x = this->modulus[0];
+    for (int i = 0; i < 6; i++) {
+        x *= 2 - this->modulus[0] * x;
+    }
+
+    this->inverse = 0 - x;
+
+    // R^2 mod modulus by doubling 1 for 2 * limbs * MONTGOMERY_LIMB_BITS times
+    memset(this->r2, 0, sizeof(this->r2));
+    this->r2[0] = 1;
+
+    for (size_t i = 0; i < 2 * this->limbs * MONTGOMERY_LIMB_BITS; i++) {
+        MontgomeryLimb carry = 0;
+
+        for (size_t j = 0; j < this->limbs; j++) {
+            MontgomeryLimb limb = this->r2[j];
+            this->r2[j] = (limb << 1) | carry;
+            carry = limb >> (MONTGOMERY_LIMB_BITS - 1);
+        }
+
+        if (carry || !this->IsLess(this->r2, this->modulus)) {
+            this->SubtractModulus(this->r2);
+        }
+    }
+
+    return true;
+}
+
+size_t Montgomery::GetLength() const {
+    return this->length;
+}
+
+bool Montgomery::ModExp(const uint8_t *base, size_t baseLength, const uint8_t *exponent, size_t exponentLength, uint8_t *result) const {
+    if (!this->limbs) {
+        return false;
+    }
+
+    // Skip leading zeros
+    while (baseLength > 0 && *base == 0) {
+        base++;
+        baseLength--;
+    }
+
+    while (exponentLength > 0 && *exponent == 0) {
+        exponent++;
+        exponentLength--;
+    }
+
+    // The base has to be smaller than the modulus
+    MontgomeryLimb x[MONTGOMERY_MAX_LIMBS];
+    if (baseLength > this->length) {
+        return false;
+    }
+
+    this->FromBytes(x, base, baseLength);
+    if (!this->IsLess(x, this->modulus)) {
+        return false;
+    }
+
+    MontgomeryLimb one[MONTGOMERY_MAX_LIMBS];
+    memset(one, 0, this->limbs * sizeof(MontgomeryLimb));
+    one[0] = 1;
+
+    MontgomeryLimb power[MONTGOMERY_MAX_LIMBS];
+
+    if (exponentLength == 0) {
+        // x^0 = 1
+        memcpy(power, one, this->limbs * sizeof(MontgomeryLimb));
+    } else {
+        // Convert into the Montgomery form
+        this->Multiply(x, x, this->r2);
+
+        if (exponentLength <= sizeof(uint32_t)) {
+            uint32_t smallExponent = 0;
+            for (size_t i = 0; i < exponentLength; i++) {
+                smallExponent = (smallExponent << 8) | exponent[i];
+            }
+
+            this->SmallExp(power, x, smallExponent);
+        } else {
+            this->WindowExp(power, x, exponent, exponentLength);
+        }
+
+        // And back again
+        this->Multiply(power, power, one);
+    }
+
+    this->ToBytes(result, power);
+    return true;
+}
+
+void Montgomery::Multiply(MontgomeryLimb *result, const MontgomeryLimb *a, const MontgomeryLimb *b) const {
+    size_t n = this->limbs;
+
+    // Interleaved multiplication and reduction (CIOS), t has two extra limbs for the carries
+    MontgomeryLimb t[MONTGOMERY_MAX_LIMBS + 2];
+    memset(t, 0, (n + 2) * sizeof(MontgomeryLimb));
+
+    for (size_t i = 0; i < n; i++) {
+        MontgomeryProduct product;
+        MontgomeryLimb carry = 0;
+
+        for (size_t j = 0; j < n; j++) {
+            product = static_cast<MontgomeryProduct>(a[j]) * b[i] + t[j] + carry;
+            t[j] = static_cast<MontgomeryLimb>(product);
+            carry = static_cast<MontgomeryLimb>(product >> MONTGOMERY_LIMB_BITS);
+        }
+
+        product = static_cast<MontgomeryProduct>(t[n]) + carry;
+        t[n] = static_cast<MontgomeryLimb>(product);
+        t[n + 1] = static_cast<MontgomeryLimb>(product >> MONTGOMERY_LIMB_BITS);
+
+        // Add a multiple of the modulus so that the lowest limb gets zero and shift by one limb
+        MontgomeryLimb m = t[0] * this->inverse;
+
+        product = static_cast<MontgomeryProduct>(m) * this->modulus[0] + t[0];
+        carry = static_cast<MontgomeryLimb>(product >> MONTGOMERY_LIMB_BITS);
+
+        for (size_t j = 1; j < n; j++) {
+            product = static_cast<MontgomeryProduct>(m) * this->modulus[j] + t[j] + carry;
+            t[j - 1] = static_cast<MontgomeryLimb>(product);
+            carry = static_cast<MontgomeryLimb>(product >> MONTGOMERY_LIMB_BITS);
+        }
+
+        product = static_cast<MontgomeryProduct>(t[n]) + carry;
+        t[n - 1] = static_cast<MontgomeryLimb>(product);
+        t[n] = t[n + 1] + static_cast<MontgomeryLimb>(product >> MONTGOMERY_LIMB_BITS);
+    }
+
+    // The result is smaller than two times the modulus
+    if (t[n] || !this->IsLess(t, this->modulus)) {
+        this->SubtractModulus(t);
+    }
+
+    memcpy(result, t, n * sizeof(MontgomeryLimb));
+}
+
+void Montgomery::SmallExp(MontgomeryLimb *result, const MontgomeryLimb *base, uint32_t exponent) const {
+    int bit = 31;
+    while (!(exponent & (1u << bit))) {
+        bit--;
+    }
+
+    // Left to right square and multiply, 65537 only needs 16 squarings and one multiplication
+    memcpy(result, base, this->limbs * sizeof(MontgomeryLimb));
+
+    for (bit--; bit >= 0; bit--) {
+        this->Multiply(result, result, result);
+
+        if (exponent & (1u << bit)) {
+            this->Multiply(result, result, base);
+        }
+    }
+}
+
+void Montgomery::WindowExp(MontgomeryLimb *result, const MontgomeryLimb *base, const uint8_t *exponent, size_t exponentLength) const {
+    size_t size = this->limbs * sizeof(MontgomeryLimb);
+
+    // Powers 0 to 15 of the base in the Montgomery form, R mod modulus is the one
+    MontgomeryLimb table[16][MONTGOMERY_MAX_LIMBS];
+    MontgomeryLimb one[MONTGOMERY_MAX_LIMBS];
+    memset(one, 0, size);
+    one[0] = 1;
+
+    this->Multiply(table[0], this->r2, one);
+    memcpy(table[1], base, size);
+
+    for (int i = 2; i < 16; i++) {
+        this->Multiply(table[i], table[i - 1], base);
+    }
+
+    memcpy(result, table[0], size);
+
+    for (size_t i = 0; i < exponentLength; i++) {
+        for (int shift = 4; shift >= 0; shift -= 4) {
+            for (int j = 0; j < 4; j++) {
+                this->Multiply(result, result, result);
+            }
+
+            int window = (exponent[i] >> shift) & 0xF;
+            if (window) {
+                this->Multiply(result, result, table[window]);
+            }
+        }
+    }
+}
+
+bool Montgomery::IsLess(const MontgomeryLimb *a, const MontgomeryLimb *b) const {
+    for (size_t i = this->limbs; i > 0; i--) {
+        if (a[i - 1] != b[i - 1]) {
+            return a[i - 1] < b[i - 1];
+        }
+    }
+
+    return false;
+}
+
+void Montgomery::SubtractModulus(MontgomeryLimb *a) const {
+    MontgomeryLimb borrow = 0;
+
+    for (size_t i = 0; i < this->limbs; i++) {
+        MontgomeryLimb limb = a[i];
+        MontgomeryLimb difference = limb - this->modulus[i] - borrow;
+
+        borrow = (limb < this->modulus[i]) || (limb == this->modulus[i] && borrow) ? 1 : 0;
+        a[i] = difference;
+    }
+}
+
+void Montgomery::FromBytes(MontgomeryLimb *limbs, const uint8_t *bytes, size_t length) const {
+    memset(limbs, 0, this->limbs * sizeof(MontgomeryLimb));
+
+    // The last byte is the least significant one
+    for (size_t i = 0; i < length; i++) {
+        limbs[i / sizeof(MontgomeryLimb)] |= static_cast<MontgomeryLimb>(bytes[length - 1 - i]) << (8 * (i % sizeof(MontgomeryLimb)));
+    }
+}
+
+void Montgomery::ToBytes(uint8_t *bytes, const MontgomeryLimb *limbs) const {
+    for (size_t i = 0; i < this->length; i++) {
+        bytes[this->length - 1 - i] = static_cast<uint8_t>(limbs[i / sizeof(MontgomeryLimb)] >> (8 * (i % sizeof(MontgomeryLimb))));
+    }
+}
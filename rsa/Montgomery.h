@@ -0,0 +1,92 @@
+/**
+ * -----------------------------------------------------
+ * File         Montgomery.h
+ * Authors      David Ordnung, Impact
+ * License      GPLv3
+ * Web          http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _INCLUDE_RSA_MONTGOMERY_H_
+#define _INCLUDE_RSA_MONTGOMERY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Use 64 bit limbs if the compiler has a 128 bit type for the products
+#if defined __SIZEOF_INT128__
+typedef uint64_t MontgomeryLimb;
+typedef unsigned __int128 MontgomeryProduct;
+#else
+typedef uint32_t MontgomeryLimb;
+typedef uint64_t MontgomeryProduct;
+#endif
+
+#define MONTGOMERY_LIMB_BITS (sizeof(MontgomeryLimb) * 8)
+#define MONTGOMERY_MAX_BITS 4096
+#define MONTGOMERY_MAX_LIMBS (MONTGOMERY_MAX_BITS / MONTGOMERY_LIMB_BITS)
+
+/**
+ * Modular exponentiation with Montgomery multiplication for an odd modulus of up to MONTGOMERY_MAX_BITS bits.
+ * All numbers are fixed width arrays, so no memory is allocated while exponentiating.
+ * It's not constant time and only meant for public key operations.
+ */
+class Montgomery {
+private:
+    MontgomeryLimb modulus[MONTGOMERY_MAX_LIMBS];
+
+    // R^2 mod modulus, to convert numbers into the Montgomery form
+    MontgomeryLimb r2[MONTGOMERY_MAX_LIMBS];
+
+    // -modulus^-1 mod 2^MONTGOMERY_LIMB_BITS
+    MontgomeryLimb inverse;
+
+    size_t limbs;
+    size_t length;
+
+public:
+    Montgomery();
+
+    // Sets the modulus as big endian bytes, fails if it's even or too large
+    bool SetModulus(const uint8_t *bytes, size_t length);
+
+    // Length of the modulus and of the results in bytes
+    size_t GetLength() const;
+
+    // result = base ^ exponent mod modulus, all big endian bytes, the result has GetLength() bytes
+    bool ModExp(const uint8_t *base, size_t baseLength, const uint8_t *exponent, size_t exponentLength, uint8_t *result) const;
+
+private:
+    void Multiply(MontgomeryLimb *result, const MontgomeryLimb *a, const MontgomeryLimb *b) const;
+
+    // Exponentiation for exponents of up to 32 bits like 65537, which only need a few multiplications
+    void SmallExp(MontgomeryLimb *result, const MontgomeryLimb *base, uint32_t exponent) const;
+
+    // Exponentiation with a fixed window of four bits for larger exponents
+    void WindowExp(MontgomeryLimb *result, const MontgomeryLimb *base, const uint8_t *exponent, size_t exponentLength) const;
+
+    bool IsLess(const MontgomeryLimb *a, const MontgomeryLimb *b) const;
+    void SubtractModulus(MontgomeryLimb *a) const;
+
+    void FromBytes(MontgomeryLimb *limbs, const uint8_t *bytes, size_t length) const;
+    void ToBytes(uint8_t *bytes, const MontgomeryLimb *limbs) const;
+};
+
+#endif
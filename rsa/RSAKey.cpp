@@ -28,114 +28,88 @@
 #include "SecureRandom.h"
 #include "3rdparty/base64/base64.h"
 
-#include <algorithm>
-
 
 RSAKey::RSAKey(std::string N, std::string E) {
-    n = BigUnsignedInABase(N, 16);
-    e = BigUnsignedInABase(E, 16);
-}
+    std::vector<uint8_t> modulus = HexDecode(N);
+    n.SetModulus(modulus.data(), modulus.size());
 
-BigUnsigned *RSAKey::DoPublic(BigUnsigned *x) {
-    return new BigUnsigned(modexp(*x, e, n));
+    e = HexDecode(E);
 }
 
 std::string RSAKey::Encrypt(std::string text) {
-    BigUnsigned *m = pkcs1pad2(text, (n.bitLength() + 7) >> 3);
-    if (!m) {
-        return nullptr;
+    size_t length = n.GetLength();
+    if (!length) {
+        return "";
     }
 
-    BigUnsigned *c = DoPublic(m);
-    if (!c) {
-        delete m;
-        return nullptr;
+    std::vector<uint8_t> m;
+    if (!pkcs1pad2(text, length, m)) {
+        return "";
     }
 
-    std::string hex = HexDecode(BigUnsignedInABase(*c, 16));
-
-    delete c;
-    delete m;
+    // The encrypted text has always the length of the modulus
+    std::vector<uint8_t> c(length);
+    if (!n.ModExp(m.data(), m.size(), e.data(), e.size(), c.data())) {
+        return "";
+    }
 
-    return base64_encode(reinterpret_cast<const unsigned char*>(hex.c_str()), hex.length());
+    return base64_encode(c.data(), c.size());
 }
 
-BigUnsigned *RSAKey::pkcs1pad2(std::string s, int num) {
-    int temp = num;
-
-    if ((size_t)num < s.length() + 11) {
-        return nullptr;
+bool RSAKey::pkcs1pad2(std::string s, size_t num, std::vector<uint8_t> &padded) {
+    if (num < s.length() + 11) {
+        return false;
     }
 
-    unsigned short *ba = new unsigned short[num];
-    int i = s.length() - 1;
+    // 0x00 0x02 <nonzero random bytes> 0x00 <text>
+    padded.assign(num, 0);
 
-    while (i >= 0 && num > 0) {
-        ba[--num] = s[i--];
+    size_t i = s.length();
+    while (i > 0) {
+        padded[--num] = static_cast<uint8_t>(s[--i]);
     }
 
-    ba[--num] = 0;
-
-    SecureRandom rng;
-
-    int x[1];
-    while (num > 2) {
-        x[0] = 0;
+    padded[--num] = 0;
 
-        while (x[0] == 0) {
-            rng.NextBytes(x, 1);
-        }
-
-        ba[--num] = static_cast<unsigned short>(x[0]);
+    // Everything between 0x00 0x02 and the 0x00 before the text
+    if (!SecureRandom::NextNonZeroBytes(&padded[2], num - 2)) {
+        return false;
     }
 
+    padded[1] = 2;
+    padded[0] = 0;
 
-    ba[--num] = 2;
-    ba[--num] = 0;
-
-    ReverseArray(ba, temp);
-
-    return new BigUnsigned(BigUnsignedInABase(ba, temp - 1, 256));
+    return true;
 }
 
-std::string RSAKey::HexDecode(std::string input) {
-    static const char *const lut = "0123456789ABCDEF";
-    size_t len = input.length();
-
-    if (len & 1) {
-        return "";
-    }
-
-    std::string output;
-    output.reserve(len / 2);
-
-    for (size_t i = 0; i < len; i += 2) {
-        char a = input[i];
-        const char* p = std::lower_bound(lut, lut + 16, a);
-
-        if (*p != a) {
-            return "";
+std::vector<uint8_t> RSAKey::HexDecode(std::string input) {
+    std::vector<uint8_t> output;
+    output.reserve(input.length() / 2 + 1);
+
+    // An odd number of digits has an implicit leading zero
+    int value = input.length() & 1 ? 0 : -1;
+
+    for (size_t i = 0; i < input.length(); i++) {
+        char c = input[i];
+        int digit;
+
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return std::vector<uint8_t>();
         }
 
-        char b = input[i + 1];
-        const char* q = std::lower_bound(lut, lut + 16, b);
-
-        if (*q != b) {
-            return "";
+        if (value < 0) {
+            value = digit;
+        } else {
+            output.push_back(static_cast<uint8_t>((value << 4) | digit));
+            value = -1;
         }
-
-        output.push_back(static_cast<char>(((p - lut) << 4) | (q - lut)));
     }
 
     return output;
 }
-
-void RSAKey::ReverseArray(unsigned short *a, int len) {
-    int temp, i;
-
-    for (i = 0; i < len / 2; ++i) {
-        temp = a[len - i - 1];
-        a[len - i - 1] = a[i];
-        a[i] = static_cast<unsigned short>(temp);
-    }
-}
\ No newline at end of file
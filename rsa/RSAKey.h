@@ -27,27 +27,28 @@
 #ifndef _INCLUDE_RSA_RSA_KEY_H_
 #define _INCLUDE_RSA_RSA_KEY_H_
 
-#include "3rdparty/bigint/BigIntegerLibrary.hh"
+#include "Montgomery.h"
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 class RSAKey {
 private:
-    BigUnsigned n;
-    BigUnsigned e;
+    Montgomery n;
+    std::vector<uint8_t> e;
 
 public:
     RSAKey(std::string N, std::string E);
 
-    // Encrypt a text
+    // Encrypt a text, returns an empty string on errors
     std::string Encrypt(std::string text);
 
-private:
-    BigUnsigned *DoPublic(BigUnsigned *x);
-    BigUnsigned *pkcs1pad2(std::string s, int num);
+    // Pads a text to num bytes with nonzero random bytes, returns false if it doesn't fit
+    static bool pkcs1pad2(std::string s, size_t num, std::vector<uint8_t> &padded);
 
-    std::string HexDecode(std::string input);
+private:
 
-    void ReverseArray(unsigned short *a, int len);
+    std::vector<uint8_t> HexDecode(std::string input);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -26,84 +26,107 @@
 
 #include "SecureRandom.h"
 
-#include <algorithm>
-#include <ctime>
-#include <math.h>
+#if defined _WIN32 || defined _WIN64
+#include <windows.h>
+#define SystemFunction036 NTAPI SystemFunction036
+#include <ntsecapi.h>
+#undef SystemFunction036
+#elif defined __APPLE__
+#include <stdlib.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
 
+#include <algorithm>
 
-SecureRandom::SecureRandom() : psize(256) {
-    pptr = 0;
-    state = nullptr;
 
-    while (pptr < psize) {
-        srand(rand() + (unsigned int)std::time(0));
-        int rand1 = rand();
+bool SecureRandom::NextBytes(uint8_t *buffer, size_t length) {
+#if defined _WIN32 || defined _WIN64
+    while (length > 0) {
+        ULONG chunk = static_cast<ULONG>((std::min)(length, static_cast<size_t>(0x7FFFFFFF)));
+        if (!RtlGenRandom(buffer, chunk)) {
+            return false;
+        }
 
-        srand(rand() + (unsigned int)std::time(0));
-        int rand2 = rand();
+        buffer += chunk;
+        length -= chunk;
+    }
 
-        uint64_t t = (uint64_t)floor((rand1 * rand2) % 65537);
+    return true;
+#elif defined __APPLE__
+    arc4random_buf(buffer, length);
+    return true;
+#else
+#if defined SYS_getrandom
+    // getrandom doesn't need a file descriptor, but only exists since Linux 3.17
+    while (length > 0) {
+        long bytes = syscall(SYS_getrandom, buffer, length, 0);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            break;
+        }
 
-        pool[pptr++] = Urs(t, 8);
-        pool[pptr++] = t & 255;
+        buffer += bytes;
+        length -= bytes;
     }
 
-    pptr = 0;
-    SeedTime();
-}
+    if (length == 0) {
+        return true;
+    }
+#endif
 
-SecureRandom::~SecureRandom() {
-    if (this->state) {
-        delete state;
+    int file = open("/dev/urandom", O_RDONLY);
+    if (file < 0) {
+        return false;
     }
-}
 
-void SecureRandom::SeedInt(uint64_t x) {
-    pool[pptr++] ^= x & 255;
-    pool[pptr++] ^= (x >> 8) & 255;
-    pool[pptr++] ^= (x >> 16) & 255;
-    pool[pptr++] ^= (x >> 24) & 255;
+    while (length > 0) {
+        ssize_t bytes = read(file, buffer, length);
+        if (bytes <= 0) {
+            if (bytes < 0 && errno == EINTR) {
+                continue;
+            }
 
-    if (pptr >= psize) {
-        pptr -= psize;
+            break;
+        }
+
+        buffer += bytes;
+        length -= bytes;
     }
-}
 
-void SecureRandom::SeedTime() {
-    SeedInt(1122926989487);
+    close(file);
+    return length == 0;
+#endif
 }
 
-uint64_t SecureRandom::Urs(uint64_t a, uint64_t b) {
-    a &= 0xffffffff;
-    b &= 0x1f;
-    if (a & 0x80000000 && b > 0) {
-        a = (a >> 1) & 0x7fffffff;
-        a = a >> (b - 1);
-    } else {
-        a = (a >> b);
+bool SecureRandom::NextNonZeroBytes(uint8_t *buffer, size_t length) {
+    if (!NextBytes(buffer, length)) {
+        return false;
     }
 
-    return a;
-}
+    // Only about one of 256 bytes is zero, replace them with bytes of an extra batch
+    uint8_t extra[64];
+    size_t extraPos = sizeof(extra);
 
-int SecureRandom::GetByte() {
-    if (!state) {
-        SeedTime();
+    for (size_t i = 0; i < length; i++) {
+        while (buffer[i] == 0) {
+            if (extraPos == sizeof(extra)) {
+                if (!NextBytes(extra, sizeof(extra))) {
+                    return false;
+                }
 
-        state = new Arcfour(pool, psize);
+                extraPos = 0;
+            }
 
-        for (pptr = 0; pptr < psize; ++pptr) {
-            pool[pptr] = 0;
+            buffer[i] = extra[extraPos++];
         }
-
-        pptr = 0;
     }
 
-    return state->Next();
+    return true;
 }
-
-void SecureRandom::NextBytes(int *ba, int len) {
-    for (int i = 0; i < len; ++i) {
-        ba[i] = GetByte();
-    }
-}
\ No newline at end of file
@@ -27,29 +27,20 @@
 #ifndef _INCLUDE_RSA_SECURE_RANDOM_H_
 #define _INCLUDE_RSA_SECURE_RANDOM_H_
 
-#include "Arcfour.h"
+#include <stddef.h>
 #include <stdint.h>
 
+/**
+ * Random bytes from the random number generator of the operating system.
+ * getrandom or /dev/urandom on Linux, arc4random on OS X and RtlGenRandom on Windows.
+ */
 class SecureRandom {
-private:
-    Arcfour *state;
-    int psize;
-    uint64_t pool[256];
-    int pptr;
-
 public:
-    SecureRandom();
-    ~SecureRandom();
-
-    void NextBytes(int *ba, int len);
-
-private:
-    void SeedInt(uint64_t x);
-    void SeedTime();
-
-    uint64_t Urs(uint64_t a, uint64_t b);
+    // Fills the buffer with random bytes, returns false if there is no random source
+    static bool NextBytes(uint8_t *buffer, size_t length);
 
-    int GetByte();
+    // Same, but without zero bytes like needed for the PKCS#1 padding
+    static bool NextNonZeroBytes(uint8_t *buffer, size_t length);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,326 @@
+/**
+ * -----------------------------------------------------
+ * File			MockSteam.cpp
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "MockSteam.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+
+#define MOCK_STEAMID "76561197960265728"
+
+
+MockSteam::MockSteam() : port(0), serverSocket(-1), isRunning(false), latency(0), failureRate(0), isSessionExpired(false) {}
+
+MockSteam::~MockSteam() {
+    this->Stop();
+}
+
+bool MockSteam::Start(int port) {
+    this->serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (this->serverSocket < 0) {
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(this->serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+
+    if (bind(this->serverSocket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 || listen(this->serverSocket, 64) < 0) {
+        close(this->serverSocket);
+        this->serverSocket = -1;
+        return false;
+    }
+
+    // Get the chosen port
+    socklen_t length = sizeof(address);
+    getsockname(this->serverSocket, reinterpret_cast<struct sockaddr *>(&address), &length);
+    this->port = ntohs(address.sin_port);
+
+    this->isRunning = true;
+    this->acceptThread = std::thread(&MockSteam::AcceptConnections, this);
+
+    return true;
+}
+
+void MockSteam::Stop() {
+    if (!this->isRunning) {
+        return;
+    }
+
+    this->isRunning = false;
+
+    // Wake up all threads blocked in accept or recv
+    shutdown(this->serverSocket, SHUT_RDWR);
+    this->acceptThread.join();
+    close(this->serverSocket);
+    this->serverSocket = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (auto clientSocket = this->connectionSockets.begin(); clientSocket != this->connectionSockets.end(); clientSocket++) {
+            shutdown(*clientSocket, SHUT_RDWR);
+        }
+    }
+
+    for (auto thread = this->connectionThreads.begin(); thread != this->connectionThreads.end(); thread++) {
+        thread->join();
+    }
+
+    this->connectionThreads.clear();
+    this->connectionSockets.clear();
+}
+
+std::string MockSteam::GetUrl() {
+    return "http://127.0.0.1:" + std::to_string(this->port);
+}
+
+void MockSteam::SetLatency(int latency) {
+    this->latency = latency;
+}
+
+void MockSteam::SetFailureRate(double failureRate) {
+    this->failureRate = failureRate;
+}
+
+void MockSteam::ExpireSession() {
+    this->isSessionExpired = true;
+}
+
+unsigned int MockSteam::GetRequestCount(std::string path) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto count = this->requestCounts.find(path);
+    return count != this->requestCounts.end() ? count->second : 0;
+}
+
+void MockSteam::AcceptConnections() {
+    while (this->isRunning) {
+        int clientSocket = accept(this->serverSocket, nullptr, nullptr);
+        if (clientSocket < 0) {
+            continue;
+        }
+
+        int noDelay = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!this->isRunning) {
+            close(clientSocket);
+            break;
+        }
+
+        this->connectionSockets.push_back(clientSocket);
+        this->connectionThreads.push_back(std::thread(&MockSteam::HandleConnection, this, clientSocket));
+    }
+}
+
+void MockSteam::HandleConnection(int clientSocket) {
+    std::string buffer;
+    char data[4096];
+
+    // Keep the connection alive for following requests like steam does
+    while (this->isRunning) {
+        size_t headerEnd = buffer.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            ssize_t received = recv(clientSocket, data, sizeof(data), 0);
+            if (received <= 0) {
+                break;
+            }
+
+            buffer.append(data, received);
+            continue;
+        }
+
+        std::string header = buffer.substr(0, headerEnd);
+
+        // Read the body if there is any
+        size_t contentLength = 0;
+        size_t lengthPosition = header.find("Content-Length: ");
+        if (lengthPosition == std::string::npos) {
+            lengthPosition = header.find("Content-length: ");
+        }
+
+        if (lengthPosition != std::string::npos) {
+            contentLength = strtoul(header.c_str() + lengthPosition + 16, nullptr, 10);
+        }
+
+        bool isComplete = true;
+        while (buffer.length() < headerEnd + 4 + contentLength) {
+            ssize_t received = recv(clientSocket, data, sizeof(data), 0);
+            if (received <= 0) {
+                isComplete = false;
+                break;
+            }
+
+            buffer.append(data, received);
+        }
+
+        if (!isComplete) {
+            break;
+        }
+
+        std::string body = buffer.substr(headerEnd + 4, contentLength);
+        buffer.erase(0, headerEnd + 4 + contentLength);
+
+        // Request line is 'METHOD /path?query HTTP/1.1'
+        size_t methodEnd = header.find(' ');
+        size_t targetEnd = header.find(' ', methodEnd + 1);
+        std::string method = header.substr(0, methodEnd);
+        std::string target = header.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+
+        size_t queryStart = target.find('?');
+        std::string path = target.substr(0, queryStart);
+        std::string query = queryStart != std::string::npos ? target.substr(queryStart + 1) : std::string();
+
+        if (this->latency > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(this->latency));
+        }
+
+        std::string response = this->HandleRequest(method, path, query, body);
+        if (send(clientSocket, response.c_str(), response.length(), MSG_NOSIGNAL) < 0) {
+            break;
+        }
+    }
+
+    close(clientSocket);
+}
+
+std::string MockSteam::HandleRequest(std::string &method, std::string &path, std::string &query, std::string &body) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->requestCounts[path]++;
+    }
+
+    if (path == "/mobilelogin") {
+        return MockSteam::CreateResponse(200, "", "sessionid=mocksession; Path=/");
+    }
+
+    if (path == "/mobilelogin/getrsakey") {
+        return MockSteam::CreateResponse(200, "{\"success\":true,\"publickey_mod\":\"" MOCK_PUBLIC_KEY_MOD "\",\"publickey_exp\":\"" MOCK_PUBLIC_KEY_EXP "\",\"timestamp\":\"1\"}");
+    }
+
+    if (path == "/mobilelogin/dologin/") {
+        return MockSteam::CreateResponse(200, "{\"success\":true,\"login_complete\":true,"
+                                              "\"oauth\":\"{\\\"steamid\\\":\\\"" MOCK_STEAMID "\\\",\\\"oauth_token\\\":\\\"mocktoken\\\"}\"}");
+    }
+
+    if (path == "/ISteamWebUserPresenceOAuth/Logon/v0001") {
+        this->isSessionExpired = false;
+        return MockSteam::CreateResponse(200, "{\"umqid\":\"1\",\"error\":\"OK\"}");
+    }
+
+    if (path.find("/friends/action") != std::string::npos) {
+        return MockSteam::CreateResponse(200, "{\"success\":1}");
+    }
+
+    // All following requests need a valid session
+    if (this->isSessionExpired) {
+        return MockSteam::CreateResponse(401, "{\"error\":\"Not Logged On\"}");
+    }
+
+    if (path == "/ISteamUserOAuth/GetFriendList/v0001") {
+        return MockSteam::CreateResponse(200, "{\"friends\":[]}");
+    }
+
+    if (path == "/ISteamUserOAuth/GetUserSummaries/v0001") {
+        // Every requested user is online
+        std::string steamIds = MockSteam::GetParameter(query, "steamids");
+        std::string players;
+
+        size_t start = 0;
+        while (start < steamIds.length()) {
+            size_t end = steamIds.find(',', start);
+            if (end == std::string::npos) {
+                end = steamIds.length();
+            }
+
+            if (!players.empty()) {
+                players += ",";
+            }
+
+            players += "{\"steamid\":\"" + steamIds.substr(start, end - start) + "\",\"personastate\":1}";
+            start = end + 1;
+        }
+
+        return MockSteam::CreateResponse(200, "{\"players\":[" + players + "]}");
+    }
+
+    if (path == "/ISteamWebUserPresenceOAuth/Message/v0001") {
+        static thread_local std::mt19937 randomEngine(std::random_device{}());
+        std::uniform_real_distribution<double> distribution(0, 1);
+
+        if (this->failureRate > 0 && distribution(randomEngine) < this->failureRate) {
+            return MockSteam::CreateResponse(200, "{\"error\":\"Rate limit exceeded\"}");
+        }
+
+        return MockSteam::CreateResponse(200, "{\"error\":\"OK\"}");
+    }
+
+    return MockSteam::CreateResponse(404, "{}");
+}
+
+std::string MockSteam::GetParameter(std::string &parameters, std::string name) {
+    size_t start = 0;
+
+    while (start < parameters.length()) {
+        size_t end = parameters.find('&', start);
+        if (end == std::string::npos) {
+            end = parameters.length();
+        }
+
+        if (parameters.compare(start, name.length() + 1, name + "=") == 0) {
+            return parameters.substr(start + name.length() + 1, end - start - name.length() - 1);
+        }
+
+        start = end + 1;
+    }
+
+    return std::string();
+}
+
+std::string MockSteam::CreateResponse(int code, std::string content, std::string cookie) {
+    std::string response = "HTTP/1.1 " + std::to_string(code) + (code == 200 ? " OK" : " Error") + "\r\n";
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + std::to_string(content.length()) + "\r\n";
+
+    if (!cookie.empty()) {
+        response += "Set-Cookie: " + cookie + "\r\n";
+    }
+
+    return response + "\r\n" + content;
+}
@@ -0,0 +1,102 @@
+/**
+ * -----------------------------------------------------
+ * File			MockSteam.h
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _MOCK_STEAM_H_
+#define _MOCK_STEAM_H_
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A real 2048 bit modulus, so the RSA encryption does the same work as with steam
+#define MOCK_PUBLIC_KEY_MOD "B38258987056AA66BE0C48957343AA0916ED0AACD804AA7CFFF7F06675D8BBD5" \
+                            "C6357D71103D012993789EBE769940483A393C5C6CDFA4A2D7D892B7E4C91CAB" \
+                            "7CEDEEB3BE198FE5D74398CF5ADB250712B9E90A7643588A5CD4FB56B91F8656" \
+                            "36A40906C8E08C97B06CA5E3F586EBAD75BC9ED13CD29580CE0CD1FE73CCCAB0" \
+                            "9C9077A2ED994072E29BCB27C2B10ED478D4216A8186148B50CCCA08B79BC715" \
+                            "B540FAFF37A769AFF092B1904F0D045C56585372B8B3549005AE0FC0038ED251" \
+                            "80531DF0E6407B3E00082DF5DF8D44EF8EB6C59CCA5F543A19C7E116071EF76A" \
+                            "E74B4796F6AB2EC564316756123D12D59EF896FE43A495B56933E382334574E9"
+#define MOCK_PUBLIC_KEY_EXP "010001"
+
+/**
+ * Local HTTP server emulating the steam endpoints used by the web API.
+ * Allows to benchmark the web API reproducible without network access and credentials.
+ * Only available on POSIX systems.
+ */
+class MockSteam {
+private:
+    int port;
+    int serverSocket;
+    std::atomic<bool> isRunning;
+
+    std::thread acceptThread;
+    std::vector<std::thread> connectionThreads;
+    std::vector<int> connectionSockets;
+    std::mutex mutex;
+
+    // Delay of every response in milliseconds
+    std::atomic<int> latency;
+
+    // Chance between 0 and 1 that a message is rejected by steam
+    std::atomic<double> failureRate;
+
+    // Rejects all requests with the current session until the next logon
+    std::atomic<bool> isSessionExpired;
+
+    std::map<std::string, unsigned int> requestCounts;
+
+public:
+    MockSteam();
+    ~MockSteam();
+
+    // Starts the server on the given port, 0 chooses a free port
+    bool Start(int port = 0);
+    void Stop();
+
+    // Base URL to use as steam community and web api URL
+    std::string GetUrl();
+
+    void SetLatency(int latency);
+    void SetFailureRate(double failureRate);
+    void ExpireSession();
+
+    // Number of requests to a path, e.g. '/ISteamWebUserPresenceOAuth/Message/v0001'
+    unsigned int GetRequestCount(std::string path);
+
+private:
+    void AcceptConnections();
+    void HandleConnection(int clientSocket);
+
+    std::string HandleRequest(std::string &method, std::string &path, std::string &query, std::string &body);
+    static std::string GetParameter(std::string &parameters, std::string name);
+    static std::string CreateResponse(int code, std::string content, std::string cookie = std::string());
+};
+
+#endif
@@ -0,0 +1,624 @@
+/**
+ * -----------------------------------------------------
+ * File			benchmark.cpp
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "3rdparty/bigint/BigIntegerLibrary.hh"
+#include "Histogram.h"
+#include "MockSteam.h"
+#include "UrlEncoder.h"
+#include "WebAPI.h"
+#include "rsa/Montgomery.h"
+#include "rsa/RSAKey.h"
+
+#define STEAMID64_BASE 76561197960265728ULL
+
+// Settings of the send messages benchmark
+#define SEND_MESSAGES 50
+#define SEND_RECIPIENTS 8
+#define SEND_LATENCY 5
+
+// Number of players in the JSON parse benchmark
+#define JSON_PLAYERS 1000
+
+// Number of friends in the JSON arena benchmark, the default friend limit of steam
+#define JSON_FRIENDS 250
+
+// Length of the message for the RSA benchmarks, like a padded password
+#define RSA_LENGTH 256
+
+typedef struct {
+    const char *name;
+    void (*function)();
+} Benchmark_t;
+
+
+#ifdef __GLIBC__
+// Count the heap allocations of every thread, operator new also ends up here
+static thread_local size_t allocations = 0;
+
+extern "C" void *__libc_malloc(size_t size);
+
+extern "C" void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+#endif
+
+// Returns the number of heap allocations of one call on the calling thread or 0 if they can't be counted
+template <typename Function>
+size_t CountAllocations(Function function) {
+#ifdef __GLIBC__
+    size_t start = allocations;
+    function();
+    return allocations - start;
+#else
+    function();
+    return 0;
+#endif
+}
+
+
+// Returns the average time of one call in microseconds
+template <typename Function>
+double Measure(int iterations, Function function) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; i++) {
+        function();
+    }
+
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+void PrintResult(const char *name, const char *variant, double microseconds) {
+    printf("%-24s %-16s %12.2f us\n", name, variant, microseconds);
+}
+
+void PrintAllocations(const char *name, const char *variant, size_t count) {
+    printf("%-24s %-16s %12zu allocations\n", name, variant, count);
+}
+
+
+void BenchmarkOnlineRecipients() {
+    // A network wide admin list, where every second admin is online
+    std::vector<uint64_t> recipients;
+    Json::Value players(Json::arrayValue);
+    std::vector<PlayerSummary_t> summaries;
+
+    for (int i = 0; i < 500; i++) {
+        recipients.push_back(STEAMID64_BASE + i);
+
+        Json::Value player;
+        player["steamid"] = std::to_string(STEAMID64_BASE + i);
+        player["personastate"] = i % 2;
+        players.append(player);
+
+        PlayerSummary_t summary;
+        summary.steamId = STEAMID64_BASE + i;
+        summary.personaState = i % 2;
+        summaries.push_back(summary);
+    }
+
+    size_t online = 0;
+
+    // Previous implementation: compare every recipient with every player
+    double oldTime = Measure(20, [&]() {
+        std::vector<uint64_t> onlineRecipients;
+
+        for (auto recipient = recipients.begin(); recipient != recipients.end(); recipient++) {
+            for (int i = 0; players.isValidIndex(i); i++) {
+                std::string steam = players[i].get("steamid", "").asString();
+                int state = players[i].get("personastate", 0).asInt();
+
+                if (steam == std::to_string(*recipient) && state) {
+                    onlineRecipients.push_back(*recipient);
+                    break;
+                }
+            }
+        }
+
+        online += onlineRecipients.size();
+    });
+
+    double newTime = Measure(20, [&]() {
+        online += WebAPI::GetOnlineRecipients(summaries, recipients).size();
+    });
+
+    PrintResult("online-recipients", "nested loop", oldTime);
+    PrintResult("online-recipients", "hash set", newTime);
+}
+
+void BenchmarkSendMessages() {
+    // Local steam with a fixed latency for every request
+    MockSteam mockSteam;
+    if (!mockSteam.Start()) {
+        printf("Couldn't start the mock steam server\n");
+        return;
+    }
+
+    mockSteam.SetLatency(SEND_LATENCY);
+
+    for (int parallel = 0; parallel <= 1; parallel++) {
+        Message message;
+        message.config.steamCommunityUrl = mockSteam.GetUrl();
+        message.config.webApiUrl = mockSteam.GetUrl();
+        message.config.username = "benchmark";
+        message.config.password = "benchmark";
+        message.config.waitBetweenMessages = 0;
+        message.config.waitAfterLogout = 0;
+        message.config.waitBetweenCommunityRequests = 0;
+        message.config.parallelSend = parallel != 0;
+        message.text = "Benchmark message";
+
+        for (int i = 0; i < SEND_RECIPIENTS; i++) {
+            message.config.recipients.push_back(STEAMID64_BASE + i);
+        }
+
+        // The first message logs in, which is not measured
+        WebAPI webApi;
+        webApi.SendSteamMessage(message);
+
+        Histogram latencies;
+        int failures = 0;
+        size_t allocationCount = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < SEND_MESSAGES; i++) {
+            auto messageStart = std::chrono::steady_clock::now();
+
+            allocationCount += CountAllocations([&]() {
+                if (webApi.SendSteamMessage(message).type != WebAPIResult_SUCCESS) {
+                    failures++;
+                }
+            });
+
+            latencies.Record(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - messageStart).count()));
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const char *variant = parallel ? "parallel" : "sequential";
+
+        printf("%-24s %-16s %12.2f msg/s (%d failed)\n", "send-messages", variant, SEND_MESSAGES / seconds, failures);
+        printf("%-24s %-16s %12.2f ms p50, %.2f ms p95, %.2f ms p99\n", "send-messages", variant,
+               latencies.GetPercentile(50) / 1000.0, latencies.GetPercentile(95) / 1000.0, latencies.GetPercentile(99) / 1000.0);
+        PrintAllocations("send-messages", variant, allocationCount / SEND_MESSAGES);
+    }
+
+    mockSteam.Stop();
+}
+
+std::string ToHex(const std::vector<uint8_t> &bytes) {
+    static const char *const digits = "0123456789ABCDEF";
+    std::string hex;
+
+    for (auto byte = bytes.begin(); byte != bytes.end(); ++byte) {
+        // Without leading zeros like BigUnsignedInABase
+        if (hex.empty() && *byte == 0) {
+            continue;
+        }
+
+        hex.push_back(digits[*byte >> 4]);
+        hex.push_back(digits[*byte & 0xF]);
+    }
+
+    if (!hex.empty() && hex[0] == '0') {
+        hex.erase(0, 1);
+    }
+
+    return hex;
+}
+
+// Previous random generator of the padding: a pool seeded with srand/rand and Arcfour, read one byte at a time
+class OldSecureRandom {
+private:
+    int i;
+    int j;
+    int S[256];
+
+    uint64_t pool[256];
+    int pptr;
+    bool isSeeded;
+
+public:
+    OldSecureRandom() : i(0), j(0), pptr(0), isSeeded(false) {
+        while (pptr < 256) {
+            srand(rand() + (unsigned int)std::time(0));
+            int rand1 = rand();
+
+            srand(rand() + (unsigned int)std::time(0));
+            int rand2 = rand();
+
+            uint64_t t = (uint64_t)floor((rand1 * rand2) % 65537);
+
+            pool[pptr++] = Urs(t, 8);
+            pool[pptr++] = t & 255;
+        }
+
+        pptr = 0;
+        SeedTime();
+    }
+
+    void NextBytes(int *ba, int len) {
+        for (int k = 0; k < len; ++k) {
+            ba[k] = GetByte();
+        }
+    }
+
+private:
+    void SeedTime() {
+        uint64_t x = 1122926989487;
+
+        pool[pptr++] ^= x & 255;
+        pool[pptr++] ^= (x >> 8) & 255;
+        pool[pptr++] ^= (x >> 16) & 255;
+        pool[pptr++] ^= (x >> 24) & 255;
+
+        if (pptr >= 256) {
+            pptr -= 256;
+        }
+    }
+
+    uint64_t Urs(uint64_t a, uint64_t b) {
+        a &= 0xffffffff;
+        b &= 0x1f;
+        if (a & 0x80000000 && b > 0) {
+            a = (a >> 1) & 0x7fffffff;
+            a = a >> (b - 1);
+        } else {
+            a = (a >> b);
+        }
+
+        return a;
+    }
+
+    int GetByte() {
+        if (!isSeeded) {
+            SeedTime();
+
+            // Arcfour key setup with the pool as key
+            for (int k = 0; k < 256; ++k) {
+                S[k] = k;
+            }
+
+            int l = 0;
+            for (int k = 0; k < 256; ++k) {
+                l = (l + S[k] + pool[k]) & 255;
+                int t = S[k];
+
+                S[k] = S[l];
+                S[l] = t;
+            }
+
+            for (pptr = 0; pptr < 256; ++pptr) {
+                pool[pptr] = 0;
+            }
+
+            pptr = 0;
+            isSeeded = true;
+        }
+
+        i = (i + 1) & 255;
+        j = (j + S[i]) & 255;
+        int t = S[i];
+
+        S[i] = S[j];
+        S[j] = t;
+
+        return S[(t + S[i]) & 255];
+    }
+};
+
+// Previous padding, with a new generator for every padding
+bool OldPkcs1Pad2(std::string s, size_t num, std::vector<uint8_t> &padded) {
+    if (num < s.length() + 11) {
+        return false;
+    }
+
+    padded.assign(num, 0);
+
+    size_t i = s.length();
+    while (i > 0) {
+        padded[--num] = static_cast<uint8_t>(s[--i]);
+    }
+
+    padded[--num] = 0;
+
+    OldSecureRandom rng;
+
+    int x[1];
+    while (num > 2) {
+        x[0] = 0;
+
+        while (x[0] == 0) {
+            rng.NextBytes(x, 1);
+        }
+
+        padded[--num] = static_cast<uint8_t>(x[0]);
+    }
+
+    padded[--num] = 2;
+    padded[--num] = 0;
+
+    return true;
+}
+
+void BenchmarkRSA() {
+    std::vector<uint8_t> modulus;
+    std::string modulusHex = MOCK_PUBLIC_KEY_MOD;
+    for (size_t i = 0; i < modulusHex.length(); i += 2) {
+        modulus.push_back(static_cast<uint8_t>(std::stoi(modulusHex.substr(i, 2), nullptr, 16)));
+    }
+
+    // A padded message is always smaller than the modulus
+    std::vector<uint8_t> message(RSA_LENGTH);
+    message[1] = 2;
+    for (size_t i = 2; i < message.size(); i++) {
+        message[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+
+    std::vector<uint8_t> exponent = { 0x01, 0x00, 0x01 };
+
+    BigUnsigned n = BigUnsignedInABase(MOCK_PUBLIC_KEY_MOD, 16);
+    BigUnsigned e = BigUnsignedInABase(MOCK_PUBLIC_KEY_EXP, 16);
+    BigUnsigned m = BigUnsignedInABase(ToHex(message), 16);
+
+    Montgomery montgomery;
+    montgomery.SetModulus(modulus.data(), modulus.size());
+
+    std::vector<uint8_t> result(montgomery.GetLength());
+    std::string expected;
+
+    double oldTime = Measure(200, [&]() {
+        expected = std::string(BigUnsignedInABase(modexp(m, e, n), 16));
+    });
+
+    double newTime = Measure(200, [&]() {
+        montgomery.ModExp(message.data(), message.size(), exponent.data(), exponent.size(), result.data());
+    });
+
+    PrintResult("rsa-modexp", "bigint", oldTime);
+    PrintResult("rsa-modexp", "montgomery", newTime);
+
+    if (ToHex(result) != expected) {
+        printf("%-24s %-16s results differ\n", "rsa-modexp", "montgomery");
+    }
+
+    // Large exponents use the window exponentiation, compare it once
+    std::vector<uint8_t> largeExponent(64);
+    for (size_t i = 0; i < largeExponent.size(); i++) {
+        largeExponent[i] = static_cast<uint8_t>(i * 13 + 5);
+    }
+
+    montgomery.ModExp(message.data(), message.size(), largeExponent.data(), largeExponent.size(), result.data());
+    if (ToHex(result) != std::string(BigUnsignedInABase(modexp(m, BigUnsignedInABase(ToHex(largeExponent), 16), n), 16))) {
+        printf("%-24s %-16s results differ\n", "rsa-modexp", "large exponent");
+    }
+
+    // Complete password encryption including parsing the key and padding
+    double encryptTime = Measure(200, []() {
+        RSAKey rsaKey(MOCK_PUBLIC_KEY_MOD, MOCK_PUBLIC_KEY_EXP);
+        rsaKey.Encrypt("password");
+    });
+
+    PrintResult("rsa-encrypt", "montgomery", encryptTime);
+
+    // Padding of a short password for a 2048 bit key
+    std::vector<uint8_t> padded;
+
+    double oldPaddingTime = Measure(2000, [&]() {
+        OldPkcs1Pad2("password", RSA_LENGTH, padded);
+    });
+
+    double newPaddingTime = Measure(2000, [&]() {
+        RSAKey::pkcs1pad2("password", RSA_LENGTH, padded);
+    });
+
+    PrintResult("rsa-padding", "arcfour", oldPaddingTime);
+    PrintResult("rsa-padding", "os random", newPaddingTime);
+}
+
+void BenchmarkJsonParse() {
+    // A user summary like steam sends it, with much more fields than needed
+    std::string content = "{\"players\":[";
+    for (int i = 0; i < JSON_PLAYERS; i++) {
+        if (i > 0) {
+            content += ",";
+        }
+
+        content += "{\"steamid\":\"" + std::to_string(STEAMID64_BASE + i) + "\",\"communityvisibilitystate\":3,"
+                   "\"profilestate\":1,\"personaname\":\"Player \\u00e4 " + std::to_string(i) + "\",\"lastlogoff\":1500000000,"
+                   "\"profileurl\":\"https://steamcommunity.com/id/player/\",\"avatar\":\"https://example.com/avatar.jpg\","
+                   "\"personastate\":" + std::to_string(i % 2) + ",\"realname\":\"\",\"primaryclanid\":\"103582791429521408\","
+                   "\"timecreated\":1300000000,\"personastateflags\":0,\"loccountrycode\":\"DE\"}";
+    }
+    content += "]}";
+
+    size_t online = 0;
+
+    // Previous implementation: parse the whole tree and read the fields from it
+    double oldTime = Measure(50, [&]() {
+        Json::Value result;
+        Json::Reader reader;
+        reader.parse(content, result);
+
+        Json::Value players = result.get("players", Json::Value(Json::arrayValue));
+        for (int i = 0; players.isValidIndex(i); i++) {
+            strtoull(players[i].get("steamid", "").asCString(), nullptr, 10);
+            online += players[i].get("personastate", 0).asInt();
+        }
+    });
+
+    double newTime = Measure(50, [&]() {
+        JsonCursor json(content);
+        if (!json.EnterObject()) {
+            return;
+        }
+
+        std::string key;
+        while (json.NextKey(key)) {
+            if (key != "players" || !json.EnterArray()) {
+                json.Skip();
+                continue;
+            }
+
+            while (json.NextElement()) {
+                if (!json.EnterObject()) {
+                    continue;
+                }
+
+                uint64_t steamId;
+                int64_t personaState;
+
+                while (json.NextKey(key)) {
+                    if (key == "steamid") {
+                        json.ReadUInt64(steamId);
+                    } else if (key == "personastate") {
+                        if (json.ReadInt(personaState)) {
+                            online += personaState;
+                        }
+                    } else {
+                        json.Skip();
+                    }
+                }
+            }
+        }
+    });
+
+    PrintResult("json-parse", "json::reader", oldTime);
+    PrintResult("json-parse", "cursor", newTime);
+}
+
+void BenchmarkJsonArena() {
+    // A friend list like steam sends it
+    std::string content = "{\"friendslist\":{\"friends\":[";
+    for (int i = 0; i < JSON_FRIENDS; i++) {
+        if (i > 0) {
+            content += ",";
+        }
+
+        content += "{\"steamid\":\"" + std::to_string(STEAMID64_BASE + i) + "\",\"relationship\":\"" + (i % 10 ? "friend" : "requestrecipient") +
+                   "\",\"friend_since\":" + std::to_string(1500000000 + i) + "}";
+    }
+    content += "]}}";
+
+    Json::Reader reader;
+    size_t friends = 0;
+
+    auto parseHeap = [&]() {
+        Json::Value result;
+        reader.parse(content.data(), content.data() + content.length(), result);
+        friends += result["friendslist"]["friends"].size();
+    };
+
+    auto parseArena = [&]() {
+        Json::ValueArena arena;
+        Json::Value result;
+        reader.parse(content.data(), content.data() + content.length(), result);
+        friends += result["friendslist"]["friends"].size();
+    };
+
+    // Warm up the reader, it keeps its buffers between parses
+    parseHeap();
+
+    PrintAllocations("json-arena", "heap", CountAllocations(parseHeap));
+    PrintAllocations("json-arena", "arena", CountAllocations(parseArena));
+
+    PrintResult("json-arena", "heap", Measure(200, parseHeap));
+    PrintResult("json-arena", "arena", Measure(200, parseArena));
+}
+
+void BenchmarkUrlEncode() {
+    // An admin alert like CallAdmin sends it
+    std::string text = "New report on Server #1 (de_dust2): Player \"[GER] M\xC3\xBCller\" reported \"xX_Sniper_Xx\" for: Aimbot & wallhack! "
+                       "Join: steam://connect/127.0.0.1:27015 - 12/24 players";
+
+    size_t length = 0;
+
+    // Previous implementation: a new curl handle for every call
+    double oldTime = Measure(20000, [&]() {
+        CURL *curl = curl_easy_init();
+        char *escaped = curl_easy_escape(curl, text.c_str(), static_cast<int>(text.length()));
+        length += std::string(escaped).length();
+
+        curl_free(escaped);
+        curl_easy_cleanup(curl);
+    });
+
+    std::vector<char> buffer(UrlEncoder::GetMaxLength(text.length()));
+    double newTime = Measure(20000, [&]() {
+        length += UrlEncoder::Encode(text.data(), text.length(), buffer.data());
+    });
+
+    PrintResult("url-encode", "curl handle", oldTime);
+    PrintResult("url-encode", "table", newTime);
+
+    // Both have to encode the same way
+    char *escaped = curl_easy_escape(nullptr, text.c_str(), static_cast<int>(text.length()));
+    if (UrlEncoder::Encode(text) != escaped) {
+        printf("%-24s %-16s results differ\n", "url-encode", "table");
+    }
+
+    curl_free(escaped);
+}
+
+
+static Benchmark_t benchmarks[] = {
+    { "online-recipients", BenchmarkOnlineRecipients },
+    { "send-messages", BenchmarkSendMessages },
+    { "rsa", BenchmarkRSA },
+    { "json-parse", BenchmarkJsonParse },
+    { "json-arena", BenchmarkJsonArena },
+    { "url-encode", BenchmarkUrlEncode },
+    { nullptr, nullptr }
+};
+
+int main(int argc, const char *argv[]) {
+    // Run all benchmarks or only the given ones
+    for (int i = 0; benchmarks[i].name; i++) {
+        bool run = argc < 2;
+
+        for (int j = 1; j < argc; j++) {
+            if (strcmp(argv[j], benchmarks[i].name) == 0) {
+                run = true;
+            }
+        }
+
+        if (run) {
+            benchmarks[i].function();
+        }
+    }
+
+    return 0;
+}
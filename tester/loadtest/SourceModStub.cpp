@@ -0,0 +1,420 @@
+/**
+ * -----------------------------------------------------
+ * File			SourceModStub.cpp
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "SourceModStub.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+// Mutex, which can be locked recursively like the one of SourceMod
+class StubMutex : public IMutex {
+private:
+    std::recursive_mutex mutex;
+
+public:
+    bool TryLock() {
+        return this->mutex.try_lock();
+    }
+
+    void Lock() {
+        this->mutex.lock();
+    }
+
+    void Unlock() {
+        this->mutex.unlock();
+    }
+
+    void DestroyThis() {
+        delete this;
+    }
+};
+
+// Like the POSIX event signal of SourceMod there is no latch, a signal only wakes up a thread which already waits
+class StubEventSignal : public IEventSignal {
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+
+public:
+    void Wait() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->condition.wait(lock);
+    }
+
+    void Signal() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->condition.notify_all();
+    }
+
+    void DestroyThis() {
+        delete this;
+    }
+};
+
+class StubThreadHandle : public IThreadHandle {
+private:
+    std::thread thread;
+
+public:
+    explicit StubThreadHandle(IThread *pThread) {
+        this->thread = std::thread([this, pThread]() {
+            pThread->RunThread(this);
+            pThread->OnTerminate(this, false);
+        });
+    }
+
+    bool WaitForThread() {
+        if (!this->thread.joinable()) {
+            return false;
+        }
+
+        this->thread.join();
+        return true;
+    }
+
+    void DestroyThis() {
+        if (this->thread.joinable()) {
+            this->thread.detach();
+        }
+
+        delete this;
+    }
+};
+
+
+void StubShareSys::AddInterface(const char *name, SMInterface *iface) {
+    this->interfaces[name] = iface;
+}
+
+SPVM_NATIVE_FUNC StubShareSys::FindNative(const char *name) {
+    auto native = this->natives.find(name);
+    if (native == this->natives.end()) {
+        return nullptr;
+    }
+
+    return native->second;
+}
+
+bool StubShareSys::RequestInterface(const char *iface, unsigned int version, IExtension *myself, SMInterface **pIface) {
+    auto found = this->interfaces.find(iface);
+    if (found == this->interfaces.end()) {
+        return false;
+    }
+
+    *pIface = found->second;
+    return true;
+}
+
+void StubShareSys::AddNatives(IExtension *myself, const sp_nativeinfo_t *natives) {
+    for (; natives->name; natives++) {
+        this->natives[natives->name] = natives->func;
+    }
+}
+
+void StubShareSys::RegisterLibrary(IExtension *myself, const char *name) {}
+
+
+StubSourceMod::StubSourceMod() : isVerbose(false) {}
+
+void StubSourceMod::SetVerbose(bool isVerbose) {
+    this->isVerbose = isVerbose;
+}
+
+void StubSourceMod::RunFrame(bool simulating) {
+    // Copy the hooks, as a hook may remove itself
+    std::vector<GAME_FRAME_HOOK> hooks = this->frameHooks;
+
+    for (auto hook = hooks.begin(); hook != hooks.end(); ++hook) {
+        (*hook)(simulating);
+    }
+}
+
+size_t StubSourceMod::BuildPath(PathType type, char *buffer, size_t maxlength, const char *format, ...) {
+    char path[PLATFORM_MAX_PATH];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(path, sizeof(path), format, args);
+    va_end(args);
+
+    // Paths are relative to the working directory
+    int length = snprintf(buffer, maxlength, "./%s", path);
+    return length < 0 ? 0 : std::min(static_cast<size_t>(length), maxlength - 1);
+}
+
+void StubSourceMod::LogMessage(IExtension *pExt, const char *format, ...) {
+    if (!this->isVerbose) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    printf("[MessageBot] ");
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+void StubSourceMod::LogError(IExtension *pExt, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[MessageBot] ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+void StubSourceMod::AddGameFrameHook(GAME_FRAME_HOOK hook) {
+    this->frameHooks.push_back(hook);
+}
+
+void StubSourceMod::RemoveGameFrameHook(GAME_FRAME_HOOK hook) {
+    this->frameHooks.erase(std::remove(this->frameHooks.begin(), this->frameHooks.end(), hook), this->frameHooks.end());
+}
+
+
+IMutex *StubThreader::MakeMutex() {
+    return new StubMutex();
+}
+
+IEventSignal *StubThreader::MakeEventSignal() {
+    return new StubEventSignal();
+}
+
+void StubThreader::ThreadSleep(unsigned int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+IThreadHandle *StubThreader::MakeThread(IThread *pThread, ThreadFlags flags) {
+    return new StubThreadHandle(pThread);
+}
+
+
+IPlugin *StubPluginManager::FindPluginByContext(const sp_context_t *ctx) {
+    // The context of a stub plugin is the plugin itself
+    return reinterpret_cast<IPlugin *>(const_cast<sp_context_t *>(ctx));
+}
+
+void StubPluginManager::AddPluginsListener(IPluginsListener *listener) {
+    this->listeners.push_back(listener);
+}
+
+void StubPluginManager::RemovePluginsListener(IPluginsListener *listener) {
+    this->listeners.erase(std::remove(this->listeners.begin(), this->listeners.end(), listener), this->listeners.end());
+}
+
+
+bool StubRootConsole::AddRootConsoleCommand3(const char *cmd, const char *text, IRootConsoleCommand *pHandler) {
+    return true;
+}
+
+bool StubRootConsole::RemoveRootConsoleCommand(const char *cmd, IRootConsoleCommand *pHandler) {
+    return true;
+}
+
+void StubRootConsole::ConsolePrint(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+}
+
+void StubRootConsole::DrawGenericOption(const char *cmd, const char *text) {
+    printf("    %-16s - %s\n", cmd, text);
+}
+
+
+StubFunction::StubFunction(StubPlugin *plugin, std::function<void(const std::vector<cell_t> &, const std::vector<std::string> &)> handler)
+    : plugin(plugin), handler(handler) {}
+
+int StubFunction::PushCell(cell_t cell) {
+    this->cells.push_back(cell);
+    return 0;
+}
+
+int StubFunction::PushString(const char *string) {
+    this->strings.push_back(string);
+    return 0;
+}
+
+int StubFunction::Execute(cell_t *result) {
+    this->handler(this->cells, this->strings);
+
+    this->cells.clear();
+    this->strings.clear();
+
+    if (result) {
+        *result = 0;
+    }
+
+    return 0;
+}
+
+bool StubFunction::IsRunnable() {
+    return true;
+}
+
+IPluginRuntime *StubFunction::GetParentRuntime() {
+    return this->plugin;
+}
+
+
+StubPlugin::StubPlugin(StubShareSys *shareSys) : shareSys(shareSys) {
+    // Address 0 is never handed out
+    this->heap.push_back(0);
+}
+
+StubPlugin::~StubPlugin() {
+    for (auto function = this->functions.begin(); function != this->functions.end(); ++function) {
+        delete *function;
+    }
+}
+
+cell_t StubPlugin::AddFunction(std::function<void(const std::vector<cell_t> &, const std::vector<std::string> &)> handler) {
+    this->functions.push_back(new StubFunction(this, handler));
+    return static_cast<cell_t>(this->functions.size() - 1);
+}
+
+cell_t StubPlugin::AllocString(const char *string) {
+    size_t length = strlen(string) + 1;
+    cell_t address = this->AllocArray((length + sizeof(cell_t) - 1) / sizeof(cell_t));
+
+    memcpy(this->GetArray(address), string, length);
+    return address;
+}
+
+cell_t StubPlugin::AllocArray(size_t cells) {
+    cell_t address = static_cast<cell_t>(this->heap.size() * sizeof(cell_t));
+    this->heap.resize(this->heap.size() + cells, 0);
+
+    return address;
+}
+
+cell_t *StubPlugin::GetArray(cell_t address) {
+    return &this->heap[address / sizeof(cell_t)];
+}
+
+cell_t StubPlugin::CallNative(const char *name, std::vector<cell_t> params) {
+    SPVM_NATIVE_FUNC native = this->shareSys->FindNative(name);
+    if (!native) {
+        this->error = std::string("Native ") + name + " not found";
+        return 0;
+    }
+
+    // First parameter is the number of parameters
+    params.insert(params.begin(), static_cast<cell_t>(params.size()));
+    this->error.clear();
+
+    return native(this, params.data());
+}
+
+void StubPlugin::ResetHeap() {
+    this->heap.resize(1);
+}
+
+const std::string &StubPlugin::GetError() {
+    return this->error;
+}
+
+sp_context_t *StubPlugin::GetContext() {
+    return reinterpret_cast<sp_context_t *>(static_cast<IPlugin *>(this));
+}
+
+int StubPlugin::LocalToString(cell_t local_addr, char **addr) {
+    *addr = reinterpret_cast<char *>(this->GetArray(local_addr));
+    return 0;
+}
+
+int StubPlugin::LocalToPhysAddr(cell_t local_addr, cell_t **phys_addr) {
+    *phys_addr = this->GetArray(local_addr);
+    return 0;
+}
+
+int StubPlugin::StringToLocal(cell_t local_addr, size_t bytes, const char *source) {
+    return this->StringToLocalUTF8(local_addr, bytes, source, nullptr);
+}
+
+int StubPlugin::StringToLocalUTF8(cell_t local_addr, size_t maxbytes, const char *source, size_t *wrtnbytes) {
+    char *destination = reinterpret_cast<char *>(this->GetArray(local_addr));
+    size_t length = maxbytes ? std::min(strlen(source), maxbytes - 1) : 0;
+
+    if (maxbytes) {
+        memcpy(destination, source, length);
+        destination[length] = '\0';
+    }
+
+    if (wrtnbytes) {
+        *wrtnbytes = length;
+    }
+
+    return 0;
+}
+
+IPluginFunction *StubPlugin::GetFunctionById(cell_t func_id) {
+    if (func_id < 0 || static_cast<size_t>(func_id) >= this->functions.size()) {
+        return nullptr;
+    }
+
+    return this->functions[func_id];
+}
+
+void StubPlugin::ThrowNativeError(const char *msg, ...) {
+    char error[512];
+
+    va_list args;
+    va_start(args, msg);
+    vsnprintf(error, sizeof(error), msg, args);
+    va_end(args);
+
+    this->error = error;
+}
+
+IPluginContext *StubPlugin::GetDefaultContext() {
+    return this;
+}
+
+
+StubSourceModServices::StubSourceModServices() {
+    this->shareSys.AddInterface(SMINTERFACE_SOURCEMOD_NAME, &this->sourceMod);
+    this->shareSys.AddInterface(SMINTERFACE_FORWARDMANAGER_NAME, &this->forwardManager);
+    this->shareSys.AddInterface(SMINTERFACE_THREADER_NAME, &this->threader);
+    this->shareSys.AddInterface(SMINTERFACE_PLUGINSYSTEM_NAME, &this->pluginManager);
+    this->shareSys.AddInterface(SMINTERFACE_ROOTCONSOLE_NAME, &this->rootConsole);
+}
+
+bool StubSourceModServices::LoadExtension(char *error, size_t maxlength) {
+    return g_pExtensionIface->OnExtensionLoad(&this->extension, &this->shareSys, error, maxlength, false);
+}
+
+void StubSourceModServices::UnloadExtension() {
+    g_pExtensionIface->OnExtensionUnload();
+}
@@ -0,0 +1,194 @@
+/**
+ * -----------------------------------------------------
+ * File			SourceModStub.h
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef _SOURCEMOD_STUB_H_
+#define _SOURCEMOD_STUB_H_
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "smsdk_ext.h"
+
+/**
+ * In-process replacements for the SourceMod services used by the extension.
+ * The extension is loaded through the regular SDK entry point and its natives are called like from a plugin,
+ * so the native layer, the frame hook and the message thread run unchanged.
+ */
+
+class StubExtension : public IExtension {};
+
+class StubShareSys : public IShareSys {
+private:
+    std::map<std::string, SMInterface *> interfaces;
+    std::map<std::string, SPVM_NATIVE_FUNC> natives;
+
+public:
+    void AddInterface(const char *name, SMInterface *iface);
+    SPVM_NATIVE_FUNC FindNative(const char *name);
+
+    bool RequestInterface(const char *iface, unsigned int version, IExtension *myself, SMInterface **pIface);
+    void AddNatives(IExtension *myself, const sp_nativeinfo_t *natives);
+    void RegisterLibrary(IExtension *myself, const char *name);
+};
+
+class StubSourceMod : public ISourceMod {
+private:
+    std::vector<GAME_FRAME_HOOK> frameHooks;
+    bool isVerbose;
+
+public:
+    StubSourceMod();
+
+    // Prints log messages and not only errors
+    void SetVerbose(bool isVerbose);
+
+    // Calls all registered frame hooks like the game does every tick
+    void RunFrame(bool simulating);
+
+    size_t BuildPath(PathType type, char *buffer, size_t maxlength, const char *format, ...);
+    void LogMessage(IExtension *pExt, const char *format, ...);
+    void LogError(IExtension *pExt, const char *format, ...);
+    void AddGameFrameHook(GAME_FRAME_HOOK hook);
+    void RemoveGameFrameHook(GAME_FRAME_HOOK hook);
+};
+
+class StubForwardManager : public IForwardManager {};
+
+/**
+ * Threads and mutexes of the standard library.
+ * The event signal behaves like the POSIX one of SourceMod: a signal without a waiting thread is lost.
+ */
+class StubThreader : public IThreader {
+public:
+    IMutex *MakeMutex();
+    IEventSignal *MakeEventSignal();
+    void ThreadSleep(unsigned int ms);
+    IThreadHandle *MakeThread(IThread *pThread, ThreadFlags flags);
+};
+
+class StubPluginManager : public IPluginManager {
+private:
+    std::vector<IPluginsListener *> listeners;
+
+public:
+    IPlugin *FindPluginByContext(const sp_context_t *ctx);
+    void AddPluginsListener(IPluginsListener *listener);
+    void RemovePluginsListener(IPluginsListener *listener);
+};
+
+class StubRootConsole : public IRootConsole {
+public:
+    bool AddRootConsoleCommand3(const char *cmd, const char *text, IRootConsoleCommand *pHandler);
+    bool RemoveRootConsoleCommand(const char *cmd, IRootConsoleCommand *pHandler);
+    void ConsolePrint(const char *fmt, ...);
+    void DrawGenericOption(const char *cmd, const char *text);
+};
+
+
+class StubPlugin;
+
+// A plugin function, which hands the pushed arguments to a handler on execute
+class StubFunction : public IPluginFunction {
+private:
+    StubPlugin *plugin;
+    std::vector<cell_t> cells;
+    std::vector<std::string> strings;
+    std::function<void(const std::vector<cell_t> &, const std::vector<std::string> &)> handler;
+
+public:
+    StubFunction(StubPlugin *plugin, std::function<void(const std::vector<cell_t> &, const std::vector<std::string> &)> handler);
+
+    int PushCell(cell_t cell);
+    int PushString(const char *string);
+    int Execute(cell_t *result);
+    bool IsRunnable();
+    IPluginRuntime *GetParentRuntime();
+};
+
+/**
+ * A loaded plugin with its own context.
+ * Native arguments are placed on a heap, which is reset before every native call.
+ */
+class StubPlugin : public IPlugin, public IPluginContext, public IPluginRuntime {
+private:
+    StubShareSys *shareSys;
+    std::vector<StubFunction *> functions;
+    std::vector<cell_t> heap;
+    std::string error;
+
+public:
+    explicit StubPlugin(StubShareSys *shareSys);
+    ~StubPlugin();
+
+    // Returns the id of the new function
+    cell_t AddFunction(std::function<void(const std::vector<cell_t> &, const std::vector<std::string> &)> handler);
+
+    // Address of a string or an array on the heap
+    cell_t AllocString(const char *string);
+    cell_t AllocArray(size_t cells);
+    cell_t *GetArray(cell_t address);
+
+    // Calls a native, the parameters have to be set up with the heap functions before; the last error is reset
+    cell_t CallNative(const char *name, std::vector<cell_t> params);
+    void ResetHeap();
+    const std::string &GetError();
+
+    sp_context_t *GetContext();
+    int LocalToString(cell_t local_addr, char **addr);
+    int LocalToPhysAddr(cell_t local_addr, cell_t **phys_addr);
+    int StringToLocal(cell_t local_addr, size_t bytes, const char *source);
+    int StringToLocalUTF8(cell_t local_addr, size_t maxbytes, const char *source, size_t *wrtnbytes);
+    IPluginFunction *GetFunctionById(cell_t func_id);
+    void ThrowNativeError(const char *msg, ...);
+
+    IPluginContext *GetDefaultContext();
+};
+
+/**
+ * All services together, registered with the interface names the SDK requests.
+ */
+class StubSourceModServices {
+public:
+    StubExtension extension;
+    StubShareSys shareSys;
+    StubSourceMod sourceMod;
+    StubForwardManager forwardManager;
+    StubThreader threader;
+    StubPluginManager pluginManager;
+    StubRootConsole rootConsole;
+
+    StubSourceModServices();
+
+    // Loads and unloads the extension like SourceMod does
+    bool LoadExtension(char *error, size_t maxlength);
+    void UnloadExtension();
+};
+
+#endif
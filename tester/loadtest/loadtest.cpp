@@ -0,0 +1,395 @@
+/**
+ * -----------------------------------------------------
+ * File			loadtest.cpp
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "Histogram.h"
+#include "MockSteam.h"
+#include "natives.h"
+#include "SourceModStub.h"
+#include "WebAPIResult.h"
+
+#define STEAMID64_BASE 76561197960265728ULL
+
+typedef struct {
+    int tickRate;
+    int duration;
+    int drainTime;
+    int plugins;
+    double rate;
+    int recipients;
+    int latency;
+    double failureRate;
+    int waitBetweenMessages;
+    int messageBurst;
+    int maxQueuedMessages;
+    int dropPolicy;
+    int batchWindow;
+    int callbackBudget;
+    bool parallelSend;
+    bool verbose;
+} LoadTestSettings_t;
+
+// A plugin sending messages at a fixed rate with one callback, like the plugins using the extension
+typedef struct {
+    StubPlugin *plugin;
+    cell_t callback;
+    double credit;
+
+    // Send times of the messages, which are still waiting for their callback
+    std::deque<std::chrono::steady_clock::time_point> pending;
+} SimulatedPlugin_t;
+
+typedef struct {
+    unsigned int sent;
+    unsigned int rejected;
+    unsigned int results[WebAPIResult_QUEUE_FULL + 1];
+
+    Histogram frameTime;
+    Histogram callbackLatency;
+
+    unsigned int lateFrames;
+    unsigned int maxQueueSize;
+    unsigned int queueSizeAfterSend;
+} LoadTestResult_t;
+
+
+void PrintUsage() {
+    printf("Usage: messagebot-loadtest [options]\n");
+    printf("  --tickrate <hz>      Game frames per second (def. 66)\n");
+    printf("  --duration <s>       Time in seconds plugins send messages (def. 30)\n");
+    printf("  --drain <s>          Maximum time in seconds to wait for outstanding callbacks (def. 60)\n");
+    printf("  --plugins <n>        Number of plugins sending messages (def. 4)\n");
+    printf("  --rate <n>           Messages per second of every plugin (def. 0.25)\n");
+    printf("  --recipients <n>     Number of recipients (def. 8)\n");
+    printf("  --latency <ms>       Latency of every steam request (def. 50)\n");
+    printf("  --failures <0 - 1>   Chance that steam rejects a message (def. 0)\n");
+    printf("  --wait <ms>          OPTION_WAIT_BETWEEN_MESSAGES (def. 2000)\n");
+    printf("  --burst <n>          OPTION_MESSAGE_BURST (def. 1)\n");
+    printf("  --queue <n>          OPTION_MAX_QUEUED_MESSAGES (def. 100)\n");
+    printf("  --drop-oldest        Use DROP_POLICY_DROP_OLDEST instead of rejecting new messages\n");
+    printf("  --batch <ms>         OPTION_BATCH_WINDOW (def. 0)\n");
+    printf("  --budget <us>        OPTION_CALLBACK_BUDGET (def. 0)\n");
+    printf("  --parallel           Enable OPTION_PARALLEL_SEND\n");
+    printf("  --verbose            Enable OPTION_DEBUG and print the log of the extension\n");
+}
+
+bool ParseSettings(int argc, const char *argv[], LoadTestSettings_t &settings) {
+    for (int i = 1; i < argc; i++) {
+        const char *option = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(option, "--parallel") == 0) {
+            settings.parallelSend = true;
+            continue;
+        } else if (strcmp(option, "--drop-oldest") == 0) {
+            settings.dropPolicy = QueueDropPolicy_DROP_OLDEST;
+            continue;
+        } else if (strcmp(option, "--verbose") == 0) {
+            settings.verbose = true;
+            continue;
+        }
+
+        if (!value) {
+            return false;
+        }
+
+        if (strcmp(option, "--tickrate") == 0) {
+            settings.tickRate = atoi(value);
+        } else if (strcmp(option, "--duration") == 0) {
+            settings.duration = atoi(value);
+        } else if (strcmp(option, "--drain") == 0) {
+            settings.drainTime = atoi(value);
+        } else if (strcmp(option, "--plugins") == 0) {
+            settings.plugins = atoi(value);
+        } else if (strcmp(option, "--rate") == 0) {
+            settings.rate = atof(value);
+        } else if (strcmp(option, "--recipients") == 0) {
+            settings.recipients = atoi(value);
+        } else if (strcmp(option, "--latency") == 0) {
+            settings.latency = atoi(value);
+        } else if (strcmp(option, "--failures") == 0) {
+            settings.failureRate = atof(value);
+        } else if (strcmp(option, "--wait") == 0) {
+            settings.waitBetweenMessages = atoi(value);
+        } else if (strcmp(option, "--burst") == 0) {
+            settings.messageBurst = atoi(value);
+        } else if (strcmp(option, "--queue") == 0) {
+            settings.maxQueuedMessages = atoi(value);
+        } else if (strcmp(option, "--batch") == 0) {
+            settings.batchWindow = atoi(value);
+        } else if (strcmp(option, "--budget") == 0) {
+            settings.callbackBudget = atoi(value);
+        } else {
+            return false;
+        }
+
+        i++;
+    }
+
+    return settings.tickRate > 0 && settings.plugins > 0 && settings.recipients > 0;
+}
+
+void SetOption(StubPlugin *plugin, int option, int value) {
+    plugin->CallNative("MessageBot_SetOption", { option, value });
+}
+
+void Configure(StubPlugin *plugin, const LoadTestSettings_t &settings) {
+    // URLs are no options, point them directly to the mock server
+    plugin->ResetHeap();
+    plugin->CallNative("MessageBot_SetLoginData", { plugin->AllocString("loadtest"), plugin->AllocString("loadtest") });
+
+    for (int i = 0; i < settings.recipients; i++) {
+        plugin->ResetHeap();
+        plugin->CallNative("MessageBot_AddRecipient", { plugin->AllocString(std::to_string(STEAMID64_BASE + i).c_str()) });
+    }
+
+    SetOption(plugin, OPTION_DEBUG, settings.verbose);
+    SetOption(plugin, OPTION_WAIT_BETWEEN_MESSAGES, settings.waitBetweenMessages);
+    SetOption(plugin, OPTION_WAIT_AFTER_LOGOUT, 0);
+    SetOption(plugin, OPTION_WAIT_BETWEEN_COMMUNITY_REQUESTS, 0);
+    SetOption(plugin, OPTION_MESSAGE_BURST, settings.messageBurst);
+    SetOption(plugin, OPTION_MAX_QUEUED_MESSAGES, settings.maxQueuedMessages);
+    SetOption(plugin, OPTION_QUEUE_DROP_POLICY, settings.dropPolicy);
+    SetOption(plugin, OPTION_BATCH_WINDOW, settings.batchWindow);
+    SetOption(plugin, OPTION_CALLBACK_BUDGET, settings.callbackBudget);
+    SetOption(plugin, OPTION_PARALLEL_SEND, settings.parallelSend);
+    SetOption(plugin, OPTION_FRIEND_CHECK_INTERVAL, 0);
+}
+
+void PrintHistogram(const char *name, const char *unit, Histogram &histogram) {
+    printf("%-22s count %8u  p50 %8u  p95 %8u  p99 %8u  max %8u %s\n", name, histogram.GetCount(), histogram.GetPercentile(50),
+        histogram.GetPercentile(95), histogram.GetPercentile(99), histogram.GetMax(), unit);
+}
+
+void PrintResult(const LoadTestSettings_t &settings, LoadTestResult_t &result, StubPlugin *plugin) {
+    unsigned int outstanding = result.sent;
+    for (int type = 0; type <= WebAPIResult_QUEUE_FULL; type++) {
+        outstanding -= type == WebAPIResult_QUEUE_FULL && settings.dropPolicy != QueueDropPolicy_DROP_OLDEST ? 0 : result.results[type];
+    }
+
+    printf("\n");
+    printf("%-22s %u sent, %u rejected, %u without callback\n", "messages", result.sent, result.rejected, outstanding);
+    printf("%-22s %u success, %u no receiver, %u login error, %u api error, %u queue full\n", "callbacks",
+        result.results[WebAPIResult_SUCCESS], result.results[WebAPIResult_NO_RECEIVER], result.results[WebAPIResult_LOGIN_ERROR],
+        result.results[WebAPIResult_API_ERROR], result.results[WebAPIResult_QUEUE_FULL]);
+    printf("%-22s max %u, %u after sending (%.2f messages/s growth)\n", "queue size", result.maxQueueSize, result.queueSizeAfterSend,
+        settings.duration > 0 ? static_cast<double>(result.queueSizeAfterSend) / settings.duration : 0.0);
+    printf("%-22s %u of %u frames took longer than a tick\n", "late frames", result.lateFrames, result.frameTime.GetCount());
+
+    PrintHistogram("frame hook", "us", result.frameTime);
+    PrintHistogram("callback latency", "ms", result.callbackLatency);
+
+    // Statistics of the extension itself
+    plugin->ResetHeap();
+    cell_t stats = plugin->AllocArray(STAT_MAX);
+    plugin->CallNative("MessageBot_GetStats", { stats, STAT_MAX });
+
+    cell_t *values = plugin->GetArray(stats);
+    printf("%-22s %d calls, %d busy, p50 %d us, p99 %d us, max %d us\n", "extension frame hook", values[STAT_FRAME_HOOK_CALLS],
+        values[STAT_FRAME_HOOK_BUSY_CALLS], values[STAT_FRAME_HOOK_TIME_P50], values[STAT_FRAME_HOOK_TIME_P99], values[STAT_FRAME_HOOK_TIME_MAX]);
+    printf("%-22s p50 %d ms, p99 %d ms, max %d ms\n", "extension queue wait", values[STAT_QUEUE_WAIT_TIME_P50],
+        values[STAT_QUEUE_WAIT_TIME_P99], values[STAT_QUEUE_WAIT_TIME_MAX]);
+}
+
+int main(int argc, const char *argv[]) {
+    LoadTestSettings_t settings;
+    settings.tickRate = 66;
+    settings.duration = 30;
+    settings.drainTime = 60;
+    settings.plugins = 4;
+    settings.rate = 0.25;
+    settings.recipients = 8;
+    settings.latency = 50;
+    settings.failureRate = 0;
+    settings.waitBetweenMessages = 2000;
+    settings.messageBurst = 1;
+    settings.maxQueuedMessages = 100;
+    settings.dropPolicy = QueueDropPolicy_REJECT_NEW;
+    settings.batchWindow = 0;
+    settings.callbackBudget = 0;
+    settings.parallelSend = false;
+    settings.verbose = false;
+
+    if (!ParseSettings(argc, argv, settings)) {
+        PrintUsage();
+        return 1;
+    }
+
+    MockSteam mockSteam;
+    if (!mockSteam.Start()) {
+        printf("Couldn't start the mock steam server\n");
+        return 1;
+    }
+
+    mockSteam.SetLatency(settings.latency);
+    mockSteam.SetFailureRate(settings.failureRate);
+
+    StubSourceModServices services;
+    services.sourceMod.SetVerbose(settings.verbose);
+
+    char error[256];
+    if (!services.LoadExtension(error, sizeof(error))) {
+        printf("Couldn't load the extension: %s\n", error);
+        return 1;
+    }
+
+    messageBotConfig.steamCommunityUrl = mockSteam.GetUrl();
+    messageBotConfig.webApiUrl = mockSteam.GetUrl();
+
+    LoadTestResult_t result;
+    memset(result.results, 0, sizeof(result.results));
+    result.sent = 0;
+    result.rejected = 0;
+    result.lateFrames = 0;
+    result.maxQueueSize = 0;
+    result.queueSizeAfterSend = 0;
+
+    std::vector<SimulatedPlugin_t> plugins(settings.plugins);
+    for (auto simulated = plugins.begin(); simulated != plugins.end(); ++simulated) {
+        simulated->plugin = new StubPlugin(&services.shareSys);
+        simulated->credit = 0;
+
+        // The callback gets the result type and the error, messages are finished in the order they were sent
+        SimulatedPlugin_t *plugin = &*simulated;
+        simulated->callback = simulated->plugin->AddFunction([plugin, &result, &settings](const std::vector<cell_t> &cells, const std::vector<std::string> &strings) {
+            int type = cells.empty() ? WebAPIResult_API_ERROR : cells[0];
+            if (type >= 0 && type <= WebAPIResult_QUEUE_FULL) {
+                result.results[type]++;
+            }
+
+            // A rejected message was never waiting, a dropped one was the oldest
+            if (type == WebAPIResult_QUEUE_FULL && settings.dropPolicy != QueueDropPolicy_DROP_OLDEST) {
+                return;
+            }
+
+            if (!plugin->pending.empty()) {
+                if (type != WebAPIResult_QUEUE_FULL) {
+                    auto latency = std::chrono::steady_clock::now() - plugin->pending.front();
+                    result.callbackLatency.Record(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(latency).count()));
+                }
+
+                plugin->pending.pop_front();
+            }
+        });
+    }
+
+    Configure(plugins.front().plugin, settings);
+
+    printf("Running %d plugins with %.2f messages/s each for %d s at %d Hz against %s\n", settings.plugins, settings.rate,
+        settings.duration, settings.tickRate, mockSteam.GetUrl().c_str());
+
+    auto tickInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / settings.tickRate));
+    auto start = std::chrono::steady_clock::now();
+    auto sendEnd = start + std::chrono::seconds(settings.duration);
+    auto drainEnd = sendEnd + std::chrono::seconds(settings.drainTime);
+    auto nextTick = start;
+
+    bool isSending = true;
+
+    while (true) {
+        std::this_thread::sleep_until(nextTick);
+        nextTick += tickInterval;
+
+        auto now = std::chrono::steady_clock::now();
+        if (isSending && now >= sendEnd) {
+            isSending = false;
+            result.queueSizeAfterSend = plugins.front().plugin->CallNative("MessageBot_GetQueueSize", {});
+        }
+
+        if (!isSending) {
+            bool isDrained = true;
+            for (auto simulated = plugins.begin(); simulated != plugins.end(); ++simulated) {
+                isDrained = isDrained && simulated->pending.empty();
+            }
+
+            if (isDrained || now >= drainEnd) {
+                break;
+            }
+        }
+
+        // Plugins send their messages from the game thread
+        if (isSending) {
+            for (auto simulated = plugins.begin(); simulated != plugins.end(); ++simulated) {
+                simulated->credit += settings.rate / settings.tickRate;
+
+                while (simulated->credit >= 1.0) {
+                    simulated->credit -= 1.0;
+
+                    StubPlugin *plugin = simulated->plugin;
+                    plugin->ResetHeap();
+
+                    simulated->pending.push_back(std::chrono::steady_clock::now());
+                    if (plugin->CallNative("MessageBot_SendMessage", { simulated->callback, plugin->AllocString("Load test message") })) {
+                        result.sent++;
+                    } else {
+                        simulated->pending.pop_back();
+                        result.rejected++;
+                    }
+                }
+            }
+        }
+
+        // The frame hook of the extension is the only code running in the frame
+        auto frameStart = std::chrono::steady_clock::now();
+        services.sourceMod.RunFrame(true);
+        auto frameTime = std::chrono::steady_clock::now() - frameStart;
+
+        result.frameTime.Record(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count()));
+        if (frameTime > tickInterval) {
+            result.lateFrames++;
+        }
+
+        unsigned int queueSize = plugins.front().plugin->CallNative("MessageBot_GetQueueSize", {});
+        if (queueSize > result.maxQueueSize) {
+            result.maxQueueSize = queueSize;
+        }
+
+        // Don't try to catch up missed ticks, the game doesn't either
+        if (nextTick < std::chrono::steady_clock::now()) {
+            nextTick = std::chrono::steady_clock::now();
+        }
+    }
+
+    PrintResult(settings, result, plugins.front().plugin);
+
+    services.UnloadExtension();
+    mockSteam.Stop();
+
+    for (auto simulated = plugins.begin(); simulated != plugins.end(); ++simulated) {
+        delete simulated->plugin;
+    }
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * -----------------------------------------------------
+ * File			IExtensionSys.h
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * Minimal stand-in for the SourceMod SDK headers used by the extension.
+ * Only declares what the extension uses, so it can be compiled and driven by the load test
+ * without SourceMod. The real headers are used for the extension build.
+ */
+
+#ifndef _INCLUDE_SOURCEMOD_STUB_H_
+#define _INCLUDE_SOURCEMOD_STUB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define PLATFORM_MAX_PATH 256
+#define PLATFORM_EXTERN_C extern "C" __attribute__((visibility("default")))
+
+#define SMINTERFACE_SOURCEMOD_NAME "ISourceMod"
+#define SMINTERFACE_SOURCEMOD_VERSION 1
+#define SMINTERFACE_FORWARDMANAGER_NAME "IForwardManager"
+#define SMINTERFACE_FORWARDMANAGER_VERSION 1
+#define SMINTERFACE_THREADER_NAME "IThreader"
+#define SMINTERFACE_THREADER_VERSION 1
+#define SMINTERFACE_PLUGINSYSTEM_NAME "IPluginManager"
+#define SMINTERFACE_PLUGINSYSTEM_VERSION 1
+#define SMINTERFACE_ROOTCONSOLE_NAME "IRootConsole"
+#define SMINTERFACE_ROOTCONSOLE_VERSION 1
+
+typedef int32_t cell_t;
+
+namespace SourcePawn {
+    class IPluginContext;
+    class IPluginFunction;
+
+    typedef struct sp_context_s sp_context_t;
+
+    typedef cell_t (*SPVM_NATIVE_FUNC)(IPluginContext *, const cell_t *);
+
+    typedef struct sp_nativeinfo_s {
+        const char *name;
+        SPVM_NATIVE_FUNC func;
+    } sp_nativeinfo_t;
+
+    class IPluginRuntime {
+    public:
+        virtual IPluginContext *GetDefaultContext() = 0;
+    };
+
+    class IPluginContext {
+    public:
+        virtual sp_context_t *GetContext() = 0;
+        virtual int LocalToString(cell_t local_addr, char **addr) = 0;
+        virtual int LocalToPhysAddr(cell_t local_addr, cell_t **phys_addr) = 0;
+        virtual int StringToLocal(cell_t local_addr, size_t bytes, const char *source) = 0;
+        virtual int StringToLocalUTF8(cell_t local_addr, size_t maxbytes, const char *source, size_t *wrtnbytes) = 0;
+        virtual IPluginFunction *GetFunctionById(cell_t func_id) = 0;
+        virtual void ThrowNativeError(const char *msg, ...) = 0;
+    };
+
+    class IPluginFunction {
+    public:
+        virtual int PushCell(cell_t cell) = 0;
+        virtual int PushString(const char *string) = 0;
+        virtual int Execute(cell_t *result) = 0;
+        virtual bool IsRunnable() = 0;
+        virtual IPluginRuntime *GetParentRuntime() = 0;
+    };
+}
+
+namespace SourceMod {
+    using namespace SourcePawn;
+
+    class SMInterface {
+    public:
+        virtual ~SMInterface() {}
+    };
+
+    class IExtension {
+    public:
+        virtual ~IExtension() {}
+    };
+
+    class IShareSys {
+    public:
+        virtual bool RequestInterface(const char *iface, unsigned int version, IExtension *myself, SMInterface **pIface) = 0;
+        virtual void AddNatives(IExtension *myself, const sp_nativeinfo_t *natives) = 0;
+        virtual void RegisterLibrary(IExtension *myself, const char *name) = 0;
+    };
+
+    class IExtensionInterface {
+    public:
+        virtual ~IExtensionInterface() {}
+    };
+
+    enum PathType {
+        Path_None,
+        Path_Game,
+        Path_SM,
+        Path_SM_Rel,
+    };
+
+    typedef void (*GAME_FRAME_HOOK)(bool simulating);
+
+    class ISourceMod : public SMInterface {
+    public:
+        virtual size_t BuildPath(PathType type, char *buffer, size_t maxlength, const char *format, ...) = 0;
+        virtual void LogMessage(IExtension *pExt, const char *format, ...) = 0;
+        virtual void LogError(IExtension *pExt, const char *format, ...) = 0;
+        virtual void AddGameFrameHook(GAME_FRAME_HOOK hook) = 0;
+        virtual void RemoveGameFrameHook(GAME_FRAME_HOOK hook) = 0;
+    };
+
+    class IForwardManager : public SMInterface {};
+
+    class IMutex {
+    public:
+        virtual bool TryLock() = 0;
+        virtual void Lock() = 0;
+        virtual void Unlock() = 0;
+        virtual void DestroyThis() = 0;
+    };
+
+    class IEventSignal {
+    public:
+        virtual void Wait() = 0;
+        virtual void Signal() = 0;
+        virtual void DestroyThis() = 0;
+    };
+
+    class IThreadHandle {
+    public:
+        virtual bool WaitForThread() = 0;
+        virtual void DestroyThis() = 0;
+    };
+
+    class IThread {
+    public:
+        virtual void RunThread(IThreadHandle *pHandle) = 0;
+        virtual void OnTerminate(IThreadHandle *pHandle, bool cancel) = 0;
+    };
+
+    enum ThreadFlags {
+        Thread_Default = 0,
+        Thread_AutoRelease = 1,
+        Thread_CreateSuspended = 2,
+    };
+
+    class IThreader : public SMInterface {
+    public:
+        virtual IMutex *MakeMutex() = 0;
+        virtual IEventSignal *MakeEventSignal() = 0;
+        virtual void ThreadSleep(unsigned int ms) = 0;
+        virtual IThreadHandle *MakeThread(IThread *pThread, ThreadFlags flags) = 0;
+    };
+
+    class IPlugin {
+    public:
+        virtual ~IPlugin() {}
+    };
+
+    class IPluginsListener {
+    public:
+        virtual void OnPluginUnloaded(IPlugin *plugin) {}
+    };
+
+    class IPluginManager : public SMInterface {
+    public:
+        virtual IPlugin *FindPluginByContext(const sp_context_t *ctx) = 0;
+        virtual void AddPluginsListener(IPluginsListener *listener) = 0;
+        virtual void RemovePluginsListener(IPluginsListener *listener) = 0;
+    };
+
+    class ICommandArgs {
+    public:
+        virtual int ArgC() const = 0;
+        virtual const char *Arg(int n) const = 0;
+    };
+
+    class IRootConsoleCommand {
+    public:
+        virtual void OnRootConsoleCommand(const char *cmdname, const ICommandArgs *args) = 0;
+    };
+
+    class IRootConsole : public SMInterface {
+    public:
+        virtual bool AddRootConsoleCommand3(const char *cmd, const char *text, IRootConsoleCommand *pHandler) = 0;
+        virtual bool RemoveRootConsoleCommand(const char *cmd, IRootConsoleCommand *pHandler) = 0;
+        virtual void ConsolePrint(const char *fmt, ...) = 0;
+        virtual void DrawGenericOption(const char *cmd, const char *text) = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,2 @@
+// Everything is declared in the single stub header
+#include "IExtensionSys.h"
@@ -0,0 +1,57 @@
+/**
+ * -----------------------------------------------------
+ * File			mock.cpp
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MockSteam.h"
+
+int main(int argc, const char *argv[]) {
+    if (argc < 2 || argc > 4) {
+        printf("Usage: messagebot-mock <port> [latency in ms] [message failure rate 0 - 1]\n");
+        return 1;
+    }
+
+    MockSteam mockSteam;
+    if (!mockSteam.Start(atoi(argv[1]))) {
+        printf("Couldn't start the mock steam server on port %s\n", argv[1]);
+        return 1;
+    }
+
+    if (argc > 2) {
+        mockSteam.SetLatency(atoi(argv[2]));
+    }
+
+    if (argc > 3) {
+        mockSteam.SetFailureRate(atof(argv[3]));
+    }
+
+    printf("Mock steam server is running at %s, press enter to stop\n", mockSteam.GetUrl().c_str());
+    getchar();
+
+    mockSteam.Stop();
+    return 0;
+}
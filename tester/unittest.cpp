@@ -0,0 +1,239 @@
+/**
+ * -----------------------------------------------------
+ * File			unittest.cpp
+ * Authors		David Ordnung, Impact
+ * License		GPLv3
+ * Web			http://dordnung.de, http://gugyclan.eu
+ * -----------------------------------------------------
+ *
+ * Originally provided for CallAdmin by David Ordnung and Impact
+ *
+ * Copyright (C) 2014-2018 David Ordnung, Impact
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "Config.h"
+#include "JsonCursor.h"
+#include "MockSteam.h"
+#include "natives.h"
+#include "SourceModStub.h"
+
+#define STEAMID64_BASE 76561197960265728ULL
+
+// Number of recipients every test message is sent to
+#define TEST_RECIPIENTS 3
+
+// Maximum time in seconds to wait for the callbacks of a test
+#define TEST_TIMEOUT 10
+
+typedef struct {
+    const char *name;
+    bool (*function)();
+} Test_t;
+
+
+// Sends two messages with the configs set up by the given functions within one batch window, returns false if a callback is missing
+template <typename FirstConfig, typename SecondConfig>
+bool SendBatch(MockSteam &firstSteam, MockSteam &secondSteam, FirstConfig firstConfig, SecondConfig secondConfig) {
+    StubSourceModServices services;
+
+    char error[256];
+    if (!services.LoadExtension(error, sizeof(error))) {
+        printf("Couldn't load the extension: %s\n", error);
+        return false;
+    }
+
+    StubPlugin plugin(&services.shareSys);
+
+    int callbacks = 0;
+    cell_t callback = plugin.AddFunction([&callbacks](const std::vector<cell_t> &cells, const std::vector<std::string> &strings) {
+        callbacks++;
+    });
+
+    plugin.ResetHeap();
+    plugin.CallNative("MessageBot_SetLoginData", { plugin.AllocString("unittest"), plugin.AllocString("unittest") });
+
+    for (int i = 0; i < TEST_RECIPIENTS; i++) {
+        plugin.ResetHeap();
+        plugin.CallNative("MessageBot_AddRecipient", { plugin.AllocString(std::to_string(STEAMID64_BASE + i).c_str()) });
+    }
+
+    plugin.CallNative("MessageBot_SetOption", { OPTION_WAIT_BETWEEN_MESSAGES, 0 });
+    plugin.CallNative("MessageBot_SetOption", { OPTION_WAIT_AFTER_LOGOUT, 0 });
+    plugin.CallNative("MessageBot_SetOption", { OPTION_WAIT_BETWEEN_COMMUNITY_REQUESTS, 0 });
+    plugin.CallNative("MessageBot_SetOption", { OPTION_FRIEND_CHECK_INTERVAL, 0 });
+    plugin.CallNative("MessageBot_SetOption", { OPTION_BATCH_WINDOW, 200 });
+
+    // Both messages are queued in the same frame, so the second one is waiting when the batch is taken
+    messageBotConfig.steamCommunityUrl = firstSteam.GetUrl();
+    messageBotConfig.webApiUrl = firstSteam.GetUrl();
+    firstConfig();
+
+    plugin.ResetHeap();
+    plugin.CallNative("MessageBot_SendMessage", { callback, plugin.AllocString("First message") });
+
+    messageBotConfig.steamCommunityUrl = secondSteam.GetUrl();
+    messageBotConfig.webApiUrl = secondSteam.GetUrl();
+    secondConfig();
+
+    plugin.ResetHeap();
+    plugin.CallNative("MessageBot_SendMessage", { callback, plugin.AllocString("Second message") });
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(TEST_TIMEOUT);
+    while (callbacks < 2 && std::chrono::steady_clock::now() < end) {
+        services.sourceMod.RunFrame(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    }
+
+    services.UnloadExtension();
+    messageBotConfig.ResetConfig();
+
+    return callbacks == 2;
+}
+
+bool TestBatchSameConfig() {
+    MockSteam mockSteam;
+    if (!mockSteam.Start()) {
+        return false;
+    }
+
+    if (!SendBatch(mockSteam, mockSteam, []() {}, []() {})) {
+        return false;
+    }
+
+    // Both messages are merged into one text
+    return mockSteam.GetRequestCount("/ISteamWebUserPresenceOAuth/Message/v0001") == TEST_RECIPIENTS;
+}
+
+bool TestBatchDifferentUrl() {
+    MockSteam firstSteam;
+    MockSteam secondSteam;
+    if (!firstSteam.Start() || !secondSteam.Start()) {
+        return false;
+    }
+
+    if (!SendBatch(firstSteam, secondSteam, []() {}, []() {})) {
+        return false;
+    }
+
+    // Every message has to reach its own endpoint
+    return firstSteam.GetRequestCount("/ISteamWebUserPresenceOAuth/Message/v0001") == TEST_RECIPIENTS &&
+           secondSteam.GetRequestCount("/ISteamWebUserPresenceOAuth/Message/v0001") == TEST_RECIPIENTS;
+}
+
+bool TestBatchDifferentSettings() {
+    MockSteam mockSteam;
+    if (!mockSteam.Start()) {
+        return false;
+    }
+
+    bool isSent = SendBatch(mockSteam, mockSteam, []() {
+        messageBotConfig.parallelSend = false;
+    }, []() {
+        messageBotConfig.parallelSend = true;
+    });
+
+    if (!isSent) {
+        return false;
+    }
+
+    // The messages are sent one after another, each with its own settings
+    return mockSteam.GetRequestCount("/ISteamWebUserPresenceOAuth/Message/v0001") == 2 * TEST_RECIPIENTS;
+}
+
+// Reads the first element of a JSON array with the given reader, the cursor has to stay usable for the second element
+template <typename Value, typename Reader>
+bool ReadFirst(std::string json, bool expectedResult, Value expected, Reader reader) {
+    JsonCursor cursor(json);
+    if (!cursor.EnterArray() || !cursor.NextElement()) {
+        return false;
+    }
+
+    Value value = 0;
+    if (reader(cursor, value) != expectedResult || (expectedResult && value != expected)) {
+        return false;
+    }
+
+    int64_t second;
+    return cursor.NextElement() && cursor.ReadInt(second) && second == 1 && !cursor.HasFailed();
+}
+
+bool TestJsonUInt64Limit() {
+    auto readUInt64 = [](JsonCursor &cursor, uint64_t &value) {
+        return cursor.ReadUInt64(value);
+    };
+
+    return ReadFirst<uint64_t>("[18446744073709551615,1]", true, UINT64_MAX, readUInt64) &&
+           ReadFirst<uint64_t>("[\"18446744073709551615\",1]", true, UINT64_MAX, readUInt64) &&
+           ReadFirst<uint64_t>("[18446744073709551616,1]", false, 0, readUInt64) &&
+           ReadFirst<uint64_t>("[\"18446744073709551616\",1]", false, 0, readUInt64) &&
+           ReadFirst<uint64_t>("[184467440737095516150,1]", false, 0, readUInt64);
+}
+
+bool TestJsonIntLimit() {
+    auto readInt = [](JsonCursor &cursor, int64_t &value) {
+        return cursor.ReadInt(value);
+    };
+
+    return ReadFirst<int64_t>("[9223372036854775807,1]", true, INT64_MAX, readInt) &&
+           ReadFirst<int64_t>("[9223372036854775808,1]", false, 0, readInt) &&
+           ReadFirst<int64_t>("[-9223372036854775808,1]", true, INT64_MIN, readInt) &&
+           ReadFirst<int64_t>("[-9223372036854775809,1]", false, 0, readInt) &&
+           ReadFirst<int64_t>("[92233720368547758070,1]", false, 0, readInt);
+}
+
+
+static Test_t tests[] = {
+    { "batch-same-config", TestBatchSameConfig },
+    { "batch-different-url", TestBatchDifferentUrl },
+    { "batch-different-settings", TestBatchDifferentSettings },
+    { "json-uint64-limit", TestJsonUInt64Limit },
+    { "json-int-limit", TestJsonIntLimit },
+    { nullptr, nullptr }
+};
+
+int main(int argc, const char *argv[]) {
+    int failures = 0;
+
+    // Run all tests or only the given ones
+    for (int i = 0; tests[i].name; i++) {
+        bool run = argc < 2;
+
+        for (int j = 1; j < argc; j++) {
+            if (strcmp(argv[j], tests[i].name) == 0) {
+                run = true;
+            }
+        }
+
+        if (!run) {
+            continue;
+        }
+
+        bool isPassed = tests[i].function();
+        printf("%-32s %s\n", tests[i].name, isPassed ? "ok" : "FAILED");
+
+        if (!isPassed) {
+            failures++;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}